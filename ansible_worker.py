@@ -0,0 +1,251 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+Долгоживущий контроллер Ansible для CpuStatCheck.
+
+Запускается один раз за сессию (wsl -- python3 -u ansible_worker.py),
+заранее импортирует модули Ansible и затем принимает задания через stdin.
+Каждое задание выполняется в дочернем процессе (fork), поэтому интерпретатор
+и уже загруженные модули переиспользуются между запусками.
+
+Протокол (по одной строке):
+  stdin : {"id": 1, "args": ["-i", "inventory.ini", "ansible.yml"]}
+          {"cancel": 1}
+  stdout: @@READY <версия ansible>
+          @@OUT <id> <строка вывода>
+          @@EVT <id> <JSON-событие из callback_plugins/cpustat_events.py>
+          @@DONE <id> <код возврата>
+          @@ERROR <сообщение>
+"""
+
+import json
+import os
+import select
+import shutil
+import signal
+import sys
+import time
+
+# Пауза между SIGTERM и SIGKILL при отмене задания
+KILL_GRACE_SECONDS = 3.0
+
+
+def reexec_with_ansible_python():
+    # Ansible может стоять в отдельном окружении (pipx, venv) -
+    # берем интерпретатор из shebang ansible-playbook
+    playbook_bin = shutil.which("ansible-playbook")
+    if not playbook_bin:
+        return
+    with open(playbook_bin, "r", errors="replace") as handle:
+        shebang = handle.readline().strip()
+    if not shebang.startswith("#!"):
+        return
+    interpreter = shebang[2:].split()[0]
+    if os.path.realpath(interpreter) == os.path.realpath(sys.executable):
+        return
+    os.execv(interpreter, [interpreter, "-u", os.path.abspath(__file__)])
+
+
+def preload():
+    try:
+        import ansible  # noqa: F401
+    except ImportError:
+        reexec_with_ansible_python()
+        raise
+
+    from ansible import release
+    from ansible.cli.playbook import PlaybookCLI
+    # Прогреваем самые тяжелые модули, которые иначе грузятся на каждом запуске
+    import ansible.executor.playbook_executor  # noqa: F401
+    import ansible.inventory.manager  # noqa: F401
+    import ansible.parsing.dataloader  # noqa: F401
+    import ansible.plugins.callback.default  # noqa: F401
+    import ansible.plugins.connection.ssh  # noqa: F401
+    import ansible.vars.manager  # noqa: F401
+    return release.__version__, PlaybookCLI
+
+
+def emit(line):
+    sys.stdout.write(line + "\n")
+    sys.stdout.flush()
+
+
+def run_child(playbook_cli, args, write_fd, events_fd):
+    # Отдельная группа процессов - отмена убивает и ssh-потомков
+    os.setsid()
+    os.dup2(write_fd, 1)
+    os.dup2(write_fd, 2)
+    os.close(write_fd)
+    # События плагина идут в свой канал, отдельно от человекочитаемого вывода
+    os.environ["CPUSTAT_EVENTS_FD"] = str(events_fd)
+    sys.stdout = os.fdopen(1, "w", buffering=1)
+    sys.stderr = sys.stdout
+
+    argv = ["ansible-playbook"] + args
+    try:
+        if hasattr(playbook_cli, "cli_executor"):
+            rc = playbook_cli.cli_executor(argv)
+        else:
+            rc = playbook_cli(argv).run()
+    except SystemExit as exc:
+        rc = exc.code if isinstance(exc.code, int) else 1
+    except Exception as exc:  # pylint: disable=broad-except
+        sys.stdout.write("ERROR! %s\n" % exc)
+        rc = 250
+    sys.stdout.flush()
+    os._exit(rc or 0)
+
+
+class Job(object):
+    def __init__(self, job_id, pid, read_fd, events_fd):
+        self.job_id = job_id
+        self.pid = pid
+        self.read_fd = read_fd
+        self.events_fd = events_fd
+        self.buffer = b""
+        self.events_buffer = b""
+        # Момент, после которого группа задания получает SIGKILL
+        self.kill_deadline = None
+
+    def is_closed(self):
+        return self.read_fd is None and self.events_fd is None
+
+
+def terminate(job):
+    # Отмена: SIGTERM всей группе задания (ansible-playbook, рабочие процессы, ssh);
+    # кто не вышел за KILL_GRACE_SECONDS, получает SIGKILL в основном цикле
+    try:
+        os.killpg(job.pid, signal.SIGTERM)
+    except OSError:
+        return
+    if job.kill_deadline is None:
+        job.kill_deadline = time.monotonic() + KILL_GRACE_SECONDS
+
+
+def kill_overdue(jobs):
+    now = time.monotonic()
+    for job in set(jobs.values()):
+        if job.kill_deadline is not None and job.kill_deadline <= now:
+            job.kill_deadline = None
+            try:
+                os.killpg(job.pid, signal.SIGKILL)
+            except OSError:
+                pass
+
+
+def flush_lines(job, final=False):
+    while b"\n" in job.buffer:
+        line, job.buffer = job.buffer.split(b"\n", 1)
+        emit("@@OUT %d %s" % (job.job_id, line.decode("utf-8", "replace").rstrip("\r")))
+    if final and job.buffer:
+        emit("@@OUT %d %s" % (job.job_id, job.buffer.decode("utf-8", "replace")))
+        job.buffer = b""
+
+
+def flush_events(job):
+    # Неполную строку события не пересылаем - это не JSON
+    while b"\n" in job.events_buffer:
+        line, job.events_buffer = job.events_buffer.split(b"\n", 1)
+        if line.strip():
+            emit("@@EVT %d %s" % (job.job_id, line.decode("utf-8", "replace")))
+
+
+def main():
+    try:
+        version, playbook_cli = preload()
+    except Exception as exc:  # pylint: disable=broad-except
+        emit("@@ERROR %s" % exc)
+        return 1
+
+    os.environ.setdefault("ANSIBLE_NOCOLOR", "1")
+    os.environ.setdefault("PYTHONUNBUFFERED", "1")
+    emit("@@READY %s" % version)
+
+    jobs = {}
+    stdin_fd = sys.stdin.fileno()
+    stdin_buffer = b""
+    stdin_open = True
+
+    while stdin_open or jobs:
+        fds = list(jobs.keys())
+        if stdin_open:
+            fds.append(stdin_fd)
+        deadlines = [job.kill_deadline for job in jobs.values() if job.kill_deadline is not None]
+        timeout = max(0.0, min(deadlines) - time.monotonic()) if deadlines else None
+        readable, _, _ = select.select(fds, [], [], timeout)
+        kill_overdue(jobs)
+
+        for fd in readable:
+            if fd == stdin_fd:
+                chunk = os.read(stdin_fd, 65536)
+                if not chunk:
+                    stdin_open = False
+                    for job in set(jobs.values()):
+                        terminate(job)
+                    continue
+                stdin_buffer += chunk
+                while b"\n" in stdin_buffer:
+                    raw, stdin_buffer = stdin_buffer.split(b"\n", 1)
+                    if not raw.strip():
+                        continue
+                    try:
+                        request = json.loads(raw.decode("utf-8"))
+                    except ValueError as exc:
+                        emit("@@ERROR bad request: %s" % exc)
+                        continue
+
+                    if "cancel" in request:
+                        cancel_id = int(request["cancel"])
+                        for job in set(jobs.values()):
+                            if job.job_id == cancel_id:
+                                terminate(job)
+                        continue
+
+                    job_id = int(request["id"])
+                    read_fd, write_fd = os.pipe()
+                    events_read_fd, events_write_fd = os.pipe()
+                    pid = os.fork()
+                    if pid == 0:
+                        os.close(read_fd)
+                        os.close(events_read_fd)
+                        run_child(playbook_cli, request.get("args", []), write_fd, events_write_fd)
+                    os.close(write_fd)
+                    os.close(events_write_fd)
+                    job = Job(job_id, pid, read_fd, events_read_fd)
+                    jobs[read_fd] = job
+                    jobs[events_read_fd] = job
+                continue
+
+            job = jobs[fd]
+            chunk = os.read(fd, 65536)
+            if chunk:
+                if fd == job.events_fd:
+                    job.events_buffer += chunk
+                    flush_events(job)
+                else:
+                    job.buffer += chunk
+                    flush_lines(job)
+                continue
+
+            if fd == job.events_fd:
+                job.events_fd = None
+            else:
+                flush_lines(job, final=True)
+                job.read_fd = None
+            os.close(fd)
+            del jobs[fd]
+            if not job.is_closed():
+                continue
+
+            _, status = os.waitpid(job.pid, 0)
+            if os.WIFEXITED(status):
+                rc = os.WEXITSTATUS(status)
+            else:
+                rc = 128 + os.WTERMSIG(status)
+            emit("@@DONE %d %d" % (job.job_id, rc))
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,151 @@
+// Замер дельта-передачи архивов (deltatransfer.h) на синтетических данных.
+// Базовая версия - случайные байты (как у сжатого архива), новая получается
+// из нее заменой, вставкой и удалением случайных участков, пока правками не
+// затронута заданная доля архива. Для каждой доли печатаются размер патча,
+// доля скопированных из базы байт и время расчета. Патч выполняется bash так
+// же, как на хосте, и собранный файл сверяется с новой версией побайтно.
+//
+// bench_deltatransfer [размер архива, МБ]   по умолчанию 16
+// bench_deltatransfer --quick               2 МБ (для ctest)
+
+#include "deltatransfer.h"
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QProcess>
+#include <QRandomGenerator>
+#include <QTemporaryDir>
+#include <QTextStream>
+
+namespace {
+QByteArray randomBytes(QRandomGenerator& random, int size)
+{
+    QByteArray data(size, Qt::Uninitialized);
+    for (int i = 0; i < size; ++i) {
+        data[i] = char(random.bounded(256));
+    }
+    return data;
+}
+
+// Правки случайными участками до 8 КБ, пока их суммарный размер не достигнет доли ratio
+QByteArray mutate(const QByteArray& base, double ratio, QRandomGenerator& random)
+{
+    QByteArray data = base;
+    qint64 budget = qint64(base.size() * ratio);
+    while (budget > 0) {
+        int length = int(qMin<qint64>(budget, 1 + random.bounded(8192)));
+        int pos = random.bounded(qMax(1, data.size() - length));
+        switch (random.bounded(3)) {
+            case 0:
+                data.replace(pos, length, randomBytes(random, length));
+                break;
+            case 1:
+                data.insert(pos, randomBytes(random, length));
+                break;
+            default:
+                data.remove(pos, length);
+                break;
+        }
+        budget -= length;
+    }
+    return data;
+}
+
+QString sha256(const QByteArray& data)
+{
+    return QString::fromLatin1(QCryptographicHash::hash(data, QCryptographicHash::Sha256).toHex());
+}
+
+bool writeFile(const QString& path, const QByteArray& data)
+{
+    QFile file(path);
+    return file.open(QIODevice::WriteOnly | QIODevice::Truncate) && file.write(data) == data.size();
+}
+
+// Патч собирает <sha>.part из файла базы <baseSha> в текущем каталоге
+bool applyPatch(const QString& dir, const QString& patchName)
+{
+    QProcess bash;
+    bash.setWorkingDirectory(dir);
+#ifdef Q_OS_WIN
+    bash.start("wsl", QStringList() << "-e" << "bash" << patchName);
+#else
+    bash.start("bash", QStringList() << patchName);
+#endif
+    return bash.waitForFinished(-1) && bash.exitStatus() == QProcess::NormalExit && bash.exitCode() == 0;
+}
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+
+    int sizeMb = 16;
+    for (const QString& arg : app.arguments().mid(1)) {
+        bool ok = false;
+        int value = arg.toInt(&ok);
+        if (arg == "--quick") {
+            sizeMb = 2;
+        } else if (ok && value > 0) {
+            sizeMb = value;
+        }
+    }
+
+    QTemporaryDir dir;
+    if (!dir.isValid()) {
+        out << "Не удалось создать временный каталог\n";
+        return 1;
+    }
+
+    QRandomGenerator random(20240917u);
+    const QByteArray base = randomBytes(random, sizeMb * 1024 * 1024);
+    const QString baseSha = sha256(base);
+    const QString basePath = QDir(dir.path()).filePath(baseSha);
+    if (!writeFile(basePath, base)) {
+        out << "Не удалось записать базовую версию\n";
+        return 1;
+    }
+
+    out << QString("Архив %1 МБ, случайные данные\n").arg(sizeMb);
+    out << QString("%1 %2 %3 %4 %5 %6  %7\n")
+           .arg("правки", 8).arg("патч, КБ", 10).arg("% архива", 9)
+           .arg("из базы", 8).arg("блок", 6).arg("мс", 6).arg("сборка");
+
+    const double ratios[] = {0.001, 0.01, 0.05, 0.10, 0.25, 0.50};
+    bool allOk = true;
+    for (double ratio : ratios) {
+        const QByteArray next = mutate(base, ratio, random);
+        const QString nextSha = sha256(next);
+        const QString nextPath = QDir(dir.path()).filePath("next.bin");
+        const QString patchName = "delta.patch.sh";
+        const QString partPath = QDir(dir.path()).filePath(nextSha + ".part");
+        QFile::remove(partPath);
+
+        DeltaTransfer::Stats stats;
+        bool ok = writeFile(nextPath, next)
+                  && DeltaTransfer::buildPatch(basePath, baseSha, nextPath, nextSha,
+                                               QDir(dir.path()).filePath(patchName), &stats)
+                  && applyPatch(dir.path(), patchName);
+
+        // Собранный патчем файл должен совпасть с новой версией байт в байт
+        if (ok) {
+            QFile part(partPath);
+            ok = part.open(QIODevice::ReadOnly) && part.readAll() == next;
+        }
+        allOk = allOk && ok;
+
+        out << QString("%1 %2 %3 %4 %5 %6  %7\n")
+               .arg(QString("%1%").arg(ratio * 100, 0, 'f', 1), 8)
+               .arg(stats.patchSize / 1024, 10)
+               .arg(100.0 * stats.patchSize / qMax(1, next.size()), 9, 'f', 2)
+               .arg(QString("%1%").arg(100.0 * stats.copiedBytes / qMax(1, next.size()), 0, 'f', 1), 8)
+               .arg(stats.blockSize, 6)
+               .arg(stats.elapsedMs, 6)
+               .arg(ok ? "совпадает" : "ОШИБКА");
+        out.flush();
+    }
+
+    return allOk ? 0 : 1;
+}
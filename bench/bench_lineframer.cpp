@@ -0,0 +1,119 @@
+// Проверка и замер нарезки вывода на строки (lineframer.h).
+// Синтетический вывод подается кусками разного размера, как его отдает
+// канал процесса; строки, разрезанные границей куска, должны собираться
+// целиком, завершающий '\r' - отбрасываться. Для сравнения тот же поток
+// разбирается прежним способом - QString из куска и split с копией строк.
+//
+// bench_lineframer [объем, МБ]   по умолчанию 64
+// bench_lineframer --quick       4 МБ (для ctest)
+
+#include "lineframer.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QTextStream>
+
+namespace {
+struct Totals {
+    qint64 lines = 0;
+    qint64 bytes = 0;
+    quint32 checksum = 0;
+
+    void add(const QByteArray& line)
+    {
+        ++lines;
+        bytes += line.size();
+        for (char ch : line) {
+            checksum = checksum * 31 + uchar(ch);
+        }
+    }
+};
+
+// Строки от пустых до 300 символов, часть - с окончанием \r\n
+QByteArray syntheticOutput(QRandomGenerator& random, int size, Totals& expected)
+{
+    QByteArray output;
+    output.reserve(size + 512);
+    while (output.size() < size) {
+        QByteArray line(random.bounded(300), Qt::Uninitialized);
+        for (int i = 0; i < line.size(); ++i) {
+            line[i] = char(' ' + random.bounded(95));
+        }
+        expected.add(line);
+        output += line;
+        output += random.bounded(4) == 0 ? "\r\n" : "\n";
+    }
+    return output;
+}
+
+double mbPerSec(qint64 bytes, qint64 nsecs)
+{
+    return double(bytes) / (1024.0 * 1024.0) / (qMax<qint64>(1, nsecs) / 1e9);
+}
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+
+    int sizeMb = 64;
+    for (const QString& arg : app.arguments().mid(1)) {
+        bool ok = false;
+        int value = arg.toInt(&ok);
+        if (arg == "--quick") {
+            sizeMb = 4;
+        } else if (ok && value > 0) {
+            sizeMb = value;
+        }
+    }
+
+    QRandomGenerator random(20240917u);
+    Totals expected;
+    const QByteArray output = syntheticOutput(random, sizeMb * 1024 * 1024, expected);
+
+    out << QString("Вывод %1 МБ, строк %2\n").arg(output.size() / (1024 * 1024)).arg(expected.lines);
+    out << QString("%1 %2 %3  %4\n").arg("кусок, Б", 9).arg("LineFramer, МБ/с", 17)
+           .arg("QString+split, МБ/с", 18).arg("строки");
+
+    const int chunkSizes[] = {512, 4096, 65536, 1024 * 1024};
+    bool allOk = true;
+    for (int chunkSize : chunkSizes) {
+        // Без копий: вид на буфер
+        Totals framed;
+        LineFramer framer;
+        QElapsedTimer timer;
+        timer.start();
+        for (int offset = 0; offset < output.size(); offset += chunkSize) {
+            framer.append(output.constData() + offset, qMin(chunkSize, output.size() - offset),
+                          [&framed](const QByteArray& line) { framed.add(line); });
+        }
+        framer.flush([&framed](const QByteArray& line) { framed.add(line); });
+        qint64 framedNsecs = timer.nsecsElapsed();
+
+        // Прежний разбор: каждый кусок - в QString и split, по копии на строку
+        // (строки на границе кусков при этом разрываются)
+        qint64 splitLines = 0;
+        timer.restart();
+        for (int offset = 0; offset < output.size(); offset += chunkSize) {
+            const QString text = QString::fromUtf8(output.constData() + offset, qMin(chunkSize, output.size() - offset));
+            splitLines += text.split('\n').size();
+        }
+        qint64 splitNsecs = timer.nsecsElapsed();
+
+        // Разрезанные границей куска строки собраны целиком
+        bool ok = framed.lines == expected.lines && framed.bytes == expected.bytes
+                  && framed.checksum == expected.checksum;
+        allOk = allOk && ok;
+
+        out << QString("%1 %2 %3  %4\n")
+               .arg(chunkSize, 9)
+               .arg(mbPerSec(output.size(), framedNsecs), 17, 'f', 1)
+               .arg(mbPerSec(output.size(), splitNsecs), 18, 'f', 1)
+               .arg(QString("%1, у split обрывков: %2").arg(ok ? "совпадают" : "ОШИБКА")
+                    .arg(splitLines - expected.lines));
+        out.flush();
+    }
+
+    return allOk ? 0 : 1;
+}
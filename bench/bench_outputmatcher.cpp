@@ -0,0 +1,198 @@
+// Проверка и замер классификатора строк вывода (outputmatcher.h).
+// Сначала проверяется разбор: шаблоны с привязкой к началу строки
+// (TASK [, PLAY RECAP, fatal: [) не срабатывают в середине строки, а
+// пользовательские шаблоны получают свои биты маски. Затем синтетический
+// вывод ansible-playbook разной длины классифицируется с разным числом
+// пользовательских шаблонов: при линейном разборе МБ/с не зависят ни от
+// объема, ни от числа шаблонов.
+//
+// bench_outputmatcher [наибольший объем, МБ]   по умолчанию 64
+// bench_outputmatcher --quick                  4 МБ (для ctest)
+
+#include "outputmatcher.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QTextStream>
+#include <QVector>
+
+namespace {
+int failures = 0;
+
+void expect(QTextStream& out, bool condition, const QString& what)
+{
+    if (!condition) {
+        ++failures;
+        out << "ОШИБКА: " << what << "\n";
+    }
+}
+
+quint32 classify(const OutputMatcher& matcher, const QByteArray& line, quint64 *user = nullptr)
+{
+    return matcher.classify(line.constData(), line.size(), user);
+}
+
+void checkMatching(QTextStream& out)
+{
+    const OutputMatcher matcher = OutputMatcher::forAnsible(QStringList() << "timeout" << "error" << "disk full" << "TASK");
+
+    // Привязанные шаблоны - только с начала строки
+    expect(out, classify(matcher, "TASK [Install packages] ****") & OutputMatcher::TaskHeader,
+           "TASK [ в начале строки");
+    expect(out, !(classify(matcher, "  TASK [Install packages]") & OutputMatcher::TaskHeader),
+           "TASK [ после пробелов не заголовок задачи");
+    expect(out, !(classify(matcher, "ok: [host] => TASK [x]") & OutputMatcher::TaskHeader),
+           "TASK [ в середине строки не заголовок задачи");
+    expect(out, classify(matcher, "PLAY RECAP *****") & OutputMatcher::PlayRecap, "PLAY RECAP в начале строки");
+    expect(out, !(classify(matcher, "echo PLAY RECAP") & OutputMatcher::PlayRecap), "PLAY RECAP в середине строки");
+    expect(out, classify(matcher, "fatal: [10.0.0.1]: FAILED! => {}") & OutputMatcher::Fatal, "fatal: [ в начале строки");
+    expect(out, !(classify(matcher, "not fatal: [x]") & OutputMatcher::Fatal), "fatal: [ в середине строки");
+
+    // Непривязанные - в любом месте
+    quint32 categories = classify(matcher, "fatal: [h]: UNREACHABLE! => {}");
+    expect(out, (categories & OutputMatcher::Unreachable) && (categories & OutputMatcher::Fatal),
+           "UNREACHABLE! в середине строки вместе с fatal");
+    expect(out, classify(matcher, "x @@STEP end execute 0 12") & OutputMatcher::BundleStep, "@@STEP в середине строки");
+
+    // Биты пользовательских шаблонов - по порядку добавления
+    quint64 user = 0;
+    categories = classify(matcher, "connection timeout, error 110", &user);
+    expect(out, (categories & OutputMatcher::UserPattern) && user == 0x3, "timeout и error - биты 0 и 1");
+    classify(matcher, "write failed: disk full", &user);
+    expect(out, user == 0x4, "disk full - бит 2");
+    categories = classify(matcher, "nothing to see here", &user);
+    expect(out, !(categories & OutputMatcher::UserPattern) && user == 0, "строка без шаблонов пользователя");
+
+    // Пользовательский шаблон без привязки срабатывает и там, где заголовок задачи - нет
+    categories = classify(matcher, "  TASK [x]", &user);
+    expect(out, !(categories & OutputMatcher::TaskHeader) && user == 0x8, "пользовательский TASK в середине строки");
+    categories = classify(matcher, "TASK [x]", &user);
+    expect(out, (categories & OutputMatcher::TaskHeader) && user == 0x8, "TASK [ и пользовательский TASK вместе");
+
+    // Лимит пользовательских шаблонов
+    OutputMatcher limited;
+    for (int i = 0; i < OutputMatcher::maxUserPatterns; ++i) {
+        expect(out, limited.addUserPattern(QByteArray("p") + QByteArray::number(i)) == i, "номер пользовательского шаблона");
+    }
+    expect(out, limited.addUserPattern("extra") == -1, "шаблон сверх лимита отклоняется");
+}
+
+QByteArray randomWord(QRandomGenerator& random, int minLength, int maxLength)
+{
+    int length = minLength + random.bounded(maxLength - minLength + 1);
+    QByteArray word(length, Qt::Uninitialized);
+    for (int i = 0; i < length; ++i) {
+        word[i] = char('a' + random.bounded(26));
+    }
+    return word;
+}
+
+// Синтетический вывод -v: заголовки задач, итоги хостов и длинные строки stdout
+QByteArray syntheticOutput(QRandomGenerator& random, int size)
+{
+    QByteArray output;
+    output.reserve(size + 256);
+    int task = 0;
+    while (output.size() < size) {
+        switch (random.bounded(8)) {
+            case 0:
+                output += "TASK [Step " + QByteArray::number(++task) + "] " + QByteArray(60, '*') + "\n";
+                break;
+            case 1:
+                output += "ok: [10.0." + QByteArray::number(random.bounded(256)) + "."
+                          + QByteArray::number(random.bounded(256)) + "]\n";
+                break;
+            case 2:
+                output += "changed: [host-" + QByteArray::number(random.bounded(1000)) + "] => {\"rc\": 0}\n";
+                break;
+            default: {
+                QByteArray line;
+                const int length = 40 + random.bounded(80);
+                while (line.size() < length) {
+                    line += randomWord(random, 2, 9) + ' ';
+                }
+                output += line + "\n";
+                break;
+            }
+        }
+    }
+    return output;
+}
+
+struct Line {
+    int offset;
+    int length;
+};
+
+QVector<Line> splitLines(const QByteArray& data, int size)
+{
+    QVector<Line> lines;
+    int begin = 0;
+    while (begin < size) {
+        int end = data.indexOf('\n', begin);
+        if (end < 0 || end > size) end = size;
+        lines.append({begin, end - begin});
+        begin = end + 1;
+    }
+    return lines;
+}
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+
+    int maxMb = 64;
+    for (const QString& arg : app.arguments().mid(1)) {
+        bool ok = false;
+        int value = arg.toInt(&ok);
+        if (arg == "--quick") {
+            maxMb = 4;
+        } else if (ok && value > 0) {
+            maxMb = value;
+        }
+    }
+
+    checkMatching(out);
+    out << (failures == 0 ? "Проверка разбора: успешно\n" : "Проверка разбора: есть ошибки\n");
+
+    QRandomGenerator random(20240917u);
+    const QByteArray output = syntheticOutput(random, maxMb * 1024 * 1024);
+
+    const int patternCounts[] = {0, 8, 32, OutputMatcher::maxUserPatterns};
+    QStringList userPatterns;
+    while (userPatterns.size() < OutputMatcher::maxUserPatterns) {
+        userPatterns << QString::fromLatin1(randomWord(random, 6, 12));
+    }
+
+    out << QString("%1").arg("объем, МБ", 10);
+    for (int count : patternCounts) {
+        out << QString("%1").arg(QString("%1 шабл., МБ/с").arg(count), 18);
+    }
+    out << "\n";
+
+    for (int sizeMb = 1; sizeMb <= maxMb; sizeMb *= 4) {
+        const QVector<Line> lines = splitLines(output, sizeMb * 1024 * 1024);
+        out << QString("%1").arg(sizeMb, 10);
+        for (int count : patternCounts) {
+            const OutputMatcher matcher = OutputMatcher::forAnsible(userPatterns.mid(0, count));
+            quint32 seen = 0;
+            QElapsedTimer timer;
+            timer.start();
+            for (const Line& line : lines) {
+                quint64 user = 0;
+                seen |= matcher.classify(output.constData() + line.offset, line.length, &user);
+            }
+            qint64 nsecs = qMax<qint64>(1, timer.nsecsElapsed());
+            double mbPerSec = double(matcher.scannedBytes()) / (1024.0 * 1024.0) / (nsecs / 1e9);
+            // Заголовки задач в синтетическом выводе есть всегда
+            expect(out, seen & OutputMatcher::TaskHeader, "заголовки задач в синтетическом выводе");
+            out << QString("%1").arg(mbPerSec, 18, 'f', 1);
+        }
+        out << "\n";
+        out.flush();
+    }
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,184 @@
+# -*- coding: utf-8 -*-
+"""
+Поток событий выполнения playbook для CpuStatCheck.
+
+Пишет по одному JSON-объекту на строку (NDJSON) в файловый дескриптор из
+переменной окружения CPUSTAT_EVENTS_FD; без нее плагин ничего не делает.
+Раннер читает события вместо разбора человекочитаемого вывода.
+
+События:
+  {"event": "play_start", "play": ..., "hosts": [...], "tasks": N}
+  {"event": "task_start", "task": ..., "index": N}
+  {"event": "host_start", "host": ..., "task": ...}
+  {"event": "ok" | "failed" | "unreachable" | "skipped",
+   "host": ..., "task": ..., "changed": bool, "duration_ms": N, "msg": ...,
+   "timedout": bool (только failed)}
+  {"event": "stats", "host": ..., "ok": N, "changed": N, "failed": N,
+   "unreachable": N, "skipped": N}
+  {"event": "live", "host": ..., "task": ..., "stream": "out" | "err", "line": ...}
+  {"event": "playbook_end"}
+
+События live приходят от live_exec.py: плагин создает именованный канал,
+передает его путь задачам через CPUSTAT_LIVE_FIFO и пересылает каждую
+строку из него в поток событий.
+"""
+
+from __future__ import absolute_import, division, print_function
+__metaclass__ = type
+
+import atexit
+import json
+import os
+import shutil
+import tempfile
+import threading
+import time
+
+from ansible.plugins.callback import CallbackBase
+
+# Длинные сообщения обрезаются: строка события должна оставаться короткой
+MAX_MSG = 500
+
+
+class CallbackModule(CallbackBase):
+    CALLBACK_VERSION = 2.0
+    CALLBACK_TYPE = 'aggregate'
+    CALLBACK_NAME = 'cpustat_events'
+    # Включается сам, без callbacks_enabled в ansible.cfg
+    CALLBACK_NEEDS_WHITELIST = False
+    CALLBACK_NEEDS_ENABLED = False
+
+    def __init__(self):
+        super(CallbackModule, self).__init__()
+        self._fd = None
+        self._task_index = 0
+        self._started = {}
+        # События live пишутся из отдельного потока
+        self._lock = threading.Lock()
+        fd = os.environ.get('CPUSTAT_EVENTS_FD')
+        if fd and fd.isdigit():
+            self._fd = int(fd)
+            self._start_live_relay()
+
+    def _start_live_relay(self):
+        try:
+            live_dir = tempfile.mkdtemp(prefix='cpustat-live-')
+            path = os.path.join(live_dir, 'live.fifo')
+            os.mkfifo(path, 0o600)
+            # O_RDWR: канал не получает EOF, когда очередной писатель закрывается
+            channel = os.open(path, os.O_RDWR)
+        except OSError:
+            return
+        atexit.register(shutil.rmtree, live_dir, True)
+        # Процессы задач (fork) наследуют окружение
+        os.environ['CPUSTAT_LIVE_FIFO'] = path
+        thread = threading.Thread(target=self._relay_live, args=(channel,))
+        thread.daemon = True
+        thread.start()
+
+    def _relay_live(self, channel):
+        pending = b''
+        while self._fd is not None:
+            chunk = os.read(channel, 65536)
+            if not chunk:
+                break
+            lines = (pending + chunk).split(b'\n')
+            pending = lines.pop()
+            for raw in lines:
+                try:
+                    record = json.loads(raw.decode('utf-8', 'replace'))
+                except ValueError:
+                    continue
+                self._emit('live',
+                           host=record.get('host', ''),
+                           task=record.get('task', ''),
+                           stream=record.get('stream', 'out'),
+                           line=record.get('line', ''))
+
+    def _emit(self, event, **fields):
+        if self._fd is None:
+            return
+        fields['event'] = event
+        data = (json.dumps(fields, ensure_ascii=False, separators=(',', ':')) + '\n').encode('utf-8')
+        with self._lock:
+            try:
+                while data:
+                    written = os.write(self._fd, data)
+                    data = data[written:]
+            except OSError:
+                # Читатель закрыл канал - дальше события не нужны
+                self._fd = None
+
+    @staticmethod
+    def _count_tasks(blocks):
+        count = 0
+        for block in blocks or []:
+            if hasattr(block, 'block'):
+                count += CallbackModule._count_tasks(block.block)
+                count += CallbackModule._count_tasks(block.rescue)
+                count += CallbackModule._count_tasks(block.always)
+            else:
+                count += 1
+        return count
+
+    def _host_result(self, event, result, **fields):
+        host = result._host.get_name()
+        task_uuid = result._task._uuid
+        started = self._started.pop((host, task_uuid), None)
+        duration = int((time.time() - started) * 1000) if started else 0
+        msg = result._result.get('msg', '')
+        if not isinstance(msg, str):
+            msg = str(msg)
+        self._emit(event,
+                   host=host,
+                   task=result._task.get_name(),
+                   changed=bool(result._result.get('changed', False)),
+                   duration_ms=duration,
+                   msg=msg[:MAX_MSG],
+                   **fields)
+
+    def v2_playbook_on_play_start(self, play):
+        self._task_index = 0
+        try:
+            hosts = play.get_variable_manager()._inventory.get_hosts(play.hosts)
+            host_names = [host.get_name() for host in hosts]
+        except Exception:  # pylint: disable=broad-except
+            host_names = []
+        self._emit('play_start',
+                   play=play.get_name(),
+                   hosts=host_names,
+                   tasks=self._count_tasks(play.tasks))
+
+    def v2_playbook_on_task_start(self, task, is_conditional):
+        self._task_index += 1
+        self._emit('task_start', task=task.get_name(), index=self._task_index)
+
+    def v2_runner_on_start(self, host, task):
+        self._started[(host.get_name(), task._uuid)] = time.time()
+        self._emit('host_start', host=host.get_name(), task=task.get_name())
+
+    def v2_runner_on_ok(self, result):
+        self._host_result('ok', result)
+
+    def v2_runner_on_failed(self, result, ignore_errors=False):
+        # Предел времени задачи (timeout) Ansible отмечает полем timedout результата
+        self._host_result('failed', result, ignored=bool(ignore_errors),
+                          timedout=bool(result._result.get('timedout')))
+
+    def v2_runner_on_unreachable(self, result):
+        self._host_result('unreachable', result)
+
+    def v2_runner_on_skipped(self, result):
+        self._host_result('skipped', result)
+
+    def v2_playbook_on_stats(self, stats):
+        for host in sorted(stats.processed.keys()):
+            summary = stats.summarize(host)
+            self._emit('stats',
+                       host=host,
+                       ok=summary.get('ok', 0),
+                       changed=summary.get('changed', 0),
+                       failed=summary.get('failures', 0),
+                       unreachable=summary.get('unreachable', 0),
+                       skipped=summary.get('skipped', 0))
+        self._emit('playbook_end')
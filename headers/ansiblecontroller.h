@@ -0,0 +1,69 @@
+#ifndef ANSIBLECONTROLLER_H
+#define ANSIBLECONTROLLER_H
+
+#include <QObject>
+#include <QProcess>
+#include <QByteArray>
+#include <QMap>
+#include <QSet>
+#include "lineframer.h"
+
+// Долгоживущий процесс ansible_worker.py внутри WSL.
+// Запускается один раз за сессию, дальше запуски playbook
+// передаются ему как задания через stdin (JSON по строке на задание).
+class AnsibleController : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Код снятого задания - как у ansible-playbook, завершенного SIGTERM
+    static const int CancelledExitCode = 143;
+
+    explicit AnsibleController(QObject *parent = nullptr);
+    ~AnsibleController();
+
+    void setWorkerScriptPath(const QString& wslPath);
+    bool isReady() const { return m_ready; }
+    bool isStarted() const { return m_process->state() != QProcess::NotRunning; }
+    QString ansibleVersion() const { return m_ansibleVersion; }
+
+    // Запускает контроллер, если он еще не запущен
+    void ensureStarted();
+    // Ставит задание в очередь; возвращает идентификатор задания
+    int submitJob(const QStringList& playbookArgs);
+    void cancelJob(int jobId);
+    void shutdown();
+
+signals:
+    void ready(const QString& ansibleVersion);
+    // Строка вывода задания как есть (UTF-8), декодирует получатель
+    void jobOutput(int jobId, const QByteArray& line);
+    // Строка NDJSON плагина событий (ansibleevent.h)
+    void jobEvent(int jobId, const QByteArray& json);
+    void jobFinished(int jobId, int exitCode);
+    void controllerError(const QString& message);
+
+private slots:
+    void onProcessOutput();
+    void onProcessFinished(int exitCode, QProcess::ExitStatus status);
+    void onProcessErrorOccurred(QProcess::ProcessError error);
+
+private:
+    void handleLine(const QByteArray& line);
+    void writeRequest(const QByteArray& request);
+    void failActiveJobs();
+
+    QProcess *m_process;
+    QString m_workerScriptPath;
+    // Номер группы процессов контроллера в WSL (processtree.h)
+    QString m_pidFile;
+    QString m_ansibleVersion;
+    LineFramer m_framer;
+    // Задания, ждущие @@READY, по идентификатору (в порядке постановки)
+    QMap<int, QByteArray> m_pendingRequests;
+    QSet<int> m_activeJobs;
+    int m_nextJobId;
+    bool m_ready;
+};
+
+#endif // ANSIBLECONTROLLER_H
@@ -0,0 +1,56 @@
+#ifndef ANSIBLEEVENT_H
+#define ANSIBLEEVENT_H
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+
+// Событие выполнения playbook из плагина callback_plugins/cpustat_events.py.
+// Плагин пишет по JSON-объекту на строку (NDJSON) в отдельный канал:
+// stderr процесса ansible-playbook или строки "@@EVT <id> ..." контроллера.
+struct AnsibleEvent
+{
+    enum class Type {
+        Unknown,
+        PlayStart,
+        TaskStart,
+        HostStart,
+        HostOk,
+        HostFailed,
+        HostUnreachable,
+        HostSkipped,
+        HostStats,
+        HostLive,       // строка вывода команды, еще выполняющейся на хосте
+        PlaybookEnd
+    };
+
+    Type type = Type::Unknown;
+    QString host;
+    QString task;
+    QString message;
+    QStringList hosts;      // PlayStart
+    int taskCount = 0;      // PlayStart
+    int taskIndex = 0;      // TaskStart
+    bool changed = false;
+    bool ignored = false;   // HostFailed с ignore_errors
+    bool timedOut = false;  // HostFailed: задачу прервал предел времени (timeout)
+    qint64 durationMs = 0;
+    bool isStderr = false;  // HostLive: строка из stderr команды
+
+    // HostStats
+    int okCount = 0;
+    int changedCount = 0;
+    int failedCount = 0;
+    int unreachableCount = 0;
+    int skippedCount = 0;
+
+    bool isHostResult() const;
+
+    // Разбор одной строки NDJSON; false - строка не является событием
+    // (например, предупреждение Ansible в том же stderr)
+    static bool parse(const QByteArray& line, AnsibleEvent& event);
+    // Переменная окружения с номером дескриптора для плагина
+    static const char *fdVariable;
+};
+
+#endif // ANSIBLEEVENT_H
@@ -3,7 +3,19 @@
 
 #include <QObject>
 #include <QProcess>
+#include <QElapsedTimer>
+#include <QSet>
+#include <QTimer>
 #include "progressmanager.h"
+#include "sshexecutor.h"
+#include "ansiblecontroller.h"
+#include "concurrencytuner.h"
+#include "sshconnectionpool.h"
+#include "lineframer.h"
+#include "ansibleevent.h"
+#include "progressmodel.h"
+#include "outputmatcher.h"
+#include "reachabilityprober.h"
 #include "common.h"
 
 class AnsibleRunner : public QObject
@@ -11,16 +23,79 @@ class AnsibleRunner : public QObject
     Q_OBJECT
 
 public:
+    // Способ выполнения развертывания
+    enum class Engine {
+        AnsiblePlaybook,  // wsl -- ansible-playbook
+        NativeSsh         // собственный параллельный SSH-движок
+    };
+
+    // Итог запуска на хосте
+    enum class HostOutcome {
+        Ok,
+        Failed,
+        Unreachable,
+        TimedOut,       // превышен предел времени задачи или хоста
+        NotStarted      // до хоста не дошло: запуск прерван раньше
+    };
+
+    // Задача в итоге Unreachable хоста, отложенного проверкой доступности:
+    // скрипт на нем не запускался
+    static const char *preflightTask;
+
     explicit AnsibleRunner(QObject *parent = nullptr);
     ~AnsibleRunner();
 
     void setPlaybookPath(const QString& path);
+    // Каталог для файлов запуска (inventory, bundle, патчи); у каждого
+    // запуска из очереди свой, чтобы параллельные запуски не пересекались
+    void setStagingDir(const QString& dir);
     void setScriptPath(const QString& path);
+    void setArchivePath(const QString& path);
+    void setEngine(Engine engine);
+    Engine engine() const { return m_engine; }
+    // Использовать долгоживущий контроллер вместо нового ansible-playbook на каждый запуск
+    void setUseWarmController(bool enabled);
+    void warmUpController();
+    // Пул мастер-подключений, общий для всех исполнителей; живет в другом потоке
+    void setConnectionPool(SshConnectionPool *pool);
+    // Число параллельных ansible-playbook (шардов); 0 - по числу ядер
+    void setShardCount(int count);
+    int effectiveShardCount() const;
+    // Размер партии хостов (serial); 0 - все хосты сразу
+    void setBatchSize(int size);
+    // Параллельность (forks); 0 - автоподбор
+    void setForks(int forks);
+    // Значение автоподбора, сохраненное после прошлого запуска
+    void setRecordedConcurrency(int concurrency);
+    // Слитный режим: все шаги на хосте одним сценарием (remotebundle.h)
+    void setFusedMode(bool enabled);
+    // Потоковая передача архива с распаковкой на хосте (tar из stdin)
+    void setStreamArchive(bool enabled);
+    // Вывод скрипта в журнал построчно, пока он выполняется (live_exec.py)
+    void setLiveOutput(bool enabled);
+    // Пользовательские шаблоны: строки вывода с ними подсвечиваются и подсчитываются
+    void setOutputPatterns(const QStringList& patterns);
+    // Раздача архива деревом: degree хостов-сидов получают архив от
+    // управляющей машины и пересылают его дальше; 0 - выключено
+    void setFanoutDegree(int degree);
+    // Доля хостов с ошибкой в партии, после которой оставшиеся партии
+    // не запускаются (max_fail_percentage); 100 - не прерывать
+    void setMaxFailPercent(int percent);
+    // Пределы времени в секундах (0 - без предела): задачи (шага) на хосте и
+    // всего хоста. Хост, вышедший за предел, останавливается и получает итог
+    // TimedOut, остальные продолжают. В ansible-playbook предел хоста
+    // действует как предел каждой задачи (task_timeout)
+    void setTimeouts(int taskTimeoutSec, int hostTimeoutSec);
+    // Проверка доступности SSH-портов перед запуском (reachabilityprober.h):
+    // срок подключения к хосту, мс; 0 - без проверки. Недоступные хосты
+    // в запуск не попадают и получают итог Unreachable
+    void setPreflightTimeout(int ms);
     void setHosts(const QList<HostConfig>& hosts);
     void executePlaybook();
-    bool updateArchivePathInPlaybook(const QString& playbookPath, const QString& archivePath);
-    bool convertScriptToUnixFormat(const QString& filePath, QString& convertedPath, QString* archivePath = nullptr);
-    bool updateScriptPathInPlaybook(const QString& playbookPath, const QString& scriptPath);
+    // Проверка перетащенного скрипта и поиск архива рядом с ним
+    bool stageScript(const QString& filePath, QString* archivePath = nullptr);
+    // Копия скрипта с Unix-окончаниями строк и shebang в convertedPath
+    static bool convertScriptToUnixFormat(const QString& filePath, const QString& convertedPath, QString* error = nullptr);
     void stop();
     
     // Новый метод для установки менеджера прогресса
@@ -30,6 +105,15 @@ private slots:
     void onProcessFinished(int exitCode, QProcess::ExitStatus status);
     void onProcessErrorOccurred(QProcess::ProcessError error);
     void readProcessOutput();
+    void onNativeProgress(int completedSteps, int totalSteps, const QString& stepName);
+    void onNativeFinished(bool success);
+    void refreshEta();
+    void onControllerJobOutput(int jobId, const QByteArray& line);
+    void onControllerJobEvent(int jobId, const QByteArray& json);
+    void onControllerJobFinished(int jobId, int exitCode);
+    void onControllerError(const QString& message);
+    void onConcurrencyChanged(int concurrency);
+    void onPreflightFinished();
 
 signals:
     void outputReceived(const QString& text);
@@ -41,24 +125,147 @@ signals:
     void taskStarted(const QString& taskName);
     void taskCompleted(const QString& taskName);
 
+    // Подобранные значения для следующего запуска
+    void tuningRecorded(int concurrency, int batchSize);
+
+    // Итог проверки доступности хоста: время TCP-подключения, -1 - не подключились
+    void hostReachability(const QString& endpoint, bool reachable, qint64 latencyMs);
+
+    // Итог хоста (address:port) за запуск; испускается для каждого хоста перед finished.
+    // task - задача или шаг, на котором хост выбыл
+    void hostResult(const QString& endpoint, AnsibleRunner::HostOutcome outcome, const QString& task);
+
+    // Строка вывода, отнесенная к хосту (дублирует строку общего журнала)
+    void hostOutputReceived(const QString& endpoint, const QString& task, const QString& text);
+
 private:
-    void createInventoryFile();
-    QString convertToWslPath(const QString& windowsPath) const;
-    void parseProgressFromOutput(const QString& output);
+    // Часть inventory, выполняемая отдельным процессом ansible-playbook
+    struct ShardRun {
+        int index = 0;
+        QList<HostConfig> hosts;
+        QString inventoryPath;
+        QStringList arguments;
+        QProcess *process = nullptr;
+        // Номер группы процессов в WSL (processtree.h)
+        QString pidFile;
+        int jobId = -1;
+        // Номер текущей задачи (-1 - событий еще не было)
+        int taskIndex = -1;
+        int attempts = 0;
+        int exitCode = 0;
+        bool finished = false;
+        // Построчная нарезка stdout и stderr процесса ansible-playbook
+        LineFramer outFramer;
+        LineFramer errFramer;
+        // Кому относить строки без префикса хоста (продолжение вывода задачи)
+        QString currentTask;
+        QString currentHost;
+        bool inRecap = false;
+    };
+
+    bool createInventoryFile(const QString& path, const QList<HostConfig>& hosts);
+    QString inventoryName(const HostConfig& host, const QList<HostConfig>& hosts) const;
+    QString stagingPath(const QString& name) const;
+    void handleOutputLine(const QByteArray& line, bool isError, ShardRun& shard);
+    // Хост строки ansible-playbook по префиксу "ok: [имя]" или строке PLAY RECAP
+    void attributeLine(const QByteArray& line, quint32 kind, ShardRun& shard);
+    void onNativeOutput(const QString& text);
+    void readShardOutput(ShardRun& shard, bool flush);
+    void startDeployment();
+    void warmUpConnections();
+    void executeAnsible();
+    void executeNative();
+    void startShard(ShardRun& shard);
+    void startShardProcess(ShardRun& shard);
+    void handleShardExit(ShardRun& shard, int exitCode, bool crashed);
+    ShardRun* findShardByProcess(QObject *process);
+    ShardRun* findShardByJob(int jobId);
+    void finishRun(bool success, int exitCode);
+    void handleEvent(const AnsibleEvent& event, ShardRun& shard);
+    void updateModelProgress(const QString& host, const QString& task);
+    // Запоминает итог хоста; ошибка не перезаписывается более поздним "ok"
+    void recordHostResult(const QString& endpoint, HostOutcome outcome, const QString& task);
+    void reportHostResults();
+    bool writeBundleFile(const QString& path);
+    int effectiveForks() const;
+    // Предел времени задачи на хосте, с; 0 - без предела
+    int effectiveTaskTimeout() const;
+    void reportStartupLatency();
 
-    QProcess* ansibleProcess;
     QString playbookPath;
     QString scriptPath;
-    QString inventoryPath;
+    QString archivePath;
+    QString m_stagingDir;
     QList<HostConfig> hostsConfig;
+    // Хосты, на которых идет развертывание (без недоступных по проверке)
+    QList<HostConfig> m_runHosts;
     
     // Новый член класса для управления прогрессом
     ProgressManager* m_progressManager;
-    
-    // Для отслеживания этапов выполнения
-    int m_currentTaskIndex;
-    QStringList m_taskNames;
+    // Хосты x задачи playbook с весами по длительности (progressmodel.h)
+    ProgressModel m_progressModel;
+    // Имя хоста в inventory -> address:port и обратно; одни на все шарды запуска
+    QHash<QString, QString> m_inventoryEndpoints;
+    QHash<QString, QString> m_inventoryNames;
+    // Текущий шаг прямого SSH-выполнения по хостам - задача для журнала хоста
+    QHash<QString, QString> m_nativeSteps;
+    // Итоги хостов текущего запуска (address:port -> итог и задача)
+    QHash<QString, QPair<HostOutcome, QString>> m_hostResults;
+    // Хосты, на которых началась хотя бы одна задача
+    QSet<QString> m_touchedHosts;
+
+    // Классификатор строк вывода (outputmatcher.h)
+    OutputMatcher m_outputMatcher;
+    QStringList m_outputPatterns;
+    QVector<int> m_userPatternHits;
+
+    Engine m_engine;
+    SshExecutor* m_sshExecutor;
+
+    // Долгоживущий контроллер Ansible
+    AnsibleController* m_controller;
+    bool m_useController;
+    bool m_controllerUnavailable;
+
+    // Шарды текущего запуска
+    QList<ShardRun> m_shards;
+    int m_shardCount;
+    // Запуск остановлен: завершившиеся шарды не перезапускаются
+    bool m_stopping;
+
+    // Партии и параллельность
+    ConcurrencyTuner* m_tuner;
+    int m_batchSize;
+    int m_forks;
+    int m_recordedConcurrency;
+    bool m_fusedMode;
+    bool m_streamArchive;
+    bool m_liveOutput;
+    int m_fanoutDegree;
+    int m_maxFailPercent;
+    int m_taskTimeoutSec;
+    int m_hostTimeoutSec;
+    int m_preflightTimeoutMs;
+    ReachabilityProber *m_prober;
+    QElapsedTimer m_preflightTimer;
+
+    // Общий пул мастер-подключений SSH (владелец - очередь запусков,
+    // живет в ее потоке); без пула мастеры не поднимаются
+    SshConnectionPool* m_connectionPool;
+
+    // Замер задержки запуска: холодный (первый) и повторные запуски
+    QElapsedTimer m_runTimer;
+    // Раз в секунду пересчитывает оставшееся время хостов
+    QTimer *m_etaTimer;
+    // Последнее отправленное: оставшиеся секунды и флаг медленного хоста
+    QHash<QString, QPair<qint64, bool>> m_sentEta;
+    QSet<QString> m_slowWarned;
+    bool m_firstOutputSeen;
+    qint64 m_coldStartLatencyMs;
 
+    // Байты артефактов за запуск: отправлено и взято из кэша на хостах
+    qint64 m_cacheBytesSent;
+    qint64 m_cacheBytesSaved;
 
 };
 
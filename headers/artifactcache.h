@@ -0,0 +1,72 @@
+#ifndef ARTIFACTCACHE_H
+#define ARTIFACTCACHE_H
+
+#include <QString>
+
+// Кэш артефактов на хостах с адресацией по содержимому.
+// Скрипт и архив хешируются (SHA-256) на управляющей машине, на хосте
+// они хранятся как ~/.cache/cpustat/blobs/<sha> и передаются заново,
+// только если такого blob на хосте еще нет.
+//
+// Удаленные команды сначала печатают маркер
+//   @@CAS hit   - blob уже есть, данные не нужны
+//   @@CAS need  - ждем ровно size байт в stdin
+//   @@CAS delta - есть предыдущая версия, ждем патч (deltatransfer.h)
+// поэтому отправитель решает, передавать ли данные, по первой строке ответа.
+class ArtifactCache
+{
+public:
+    struct Artifact {
+        QString localPath;
+        QString sha256;
+        qint64 size = 0;
+
+        bool isValid() const { return !sha256.isEmpty(); }
+    };
+
+    // Патч относительно предыдущей версии, уже лежащей в кэше хоста
+    struct Delta {
+        QString baseSha;
+        QString patchPath;
+        qint64 patchSize = 0;
+
+        bool isValid() const { return !baseSha.isEmpty(); }
+    };
+
+    enum class Marker {
+        None,
+        Hit,
+        Need,
+        Delta
+    };
+
+    // Хеш файла; результат запоминается по пути, размеру и времени изменения,
+    // чтобы не перечитывать большой архив при каждом запуске
+    static Artifact describe(const QString& localPath);
+
+    // Получить blob (из кэша или из stdin с проверкой хеша) и установить его в dest.
+    // link - вместо копии создать символическую ссылку на blob (для архивов).
+    // Если задан delta и на хосте есть базовая версия, принимается патч
+    static QString fetchCommand(const Artifact& artifact, const QString& dest, bool link,
+                                const Delta& delta = Delta());
+    // Потоковая распаковка архива: из кэша, если blob есть, иначе из stdin
+    // с параллельным сохранением в кэш; в конце печатается манифест
+    static QString streamExtractCommand(const Artifact& artifact, const QString& archiveName,
+                                        const Delta& delta = Delta());
+    static Marker parseMarker(const QString& line);
+
+    static QString blobPath(const Artifact& artifact);
+    static QString formatBytes(qint64 bytes);
+
+    // Каталог кэша на хосте (~ раскрывается удаленной оболочкой)
+    static const char *remoteDir;
+    // Blob старше этого срока (в днях) удаляются при следующем обращении
+    static const int retentionDays;
+
+private:
+    static QString deltaBranch(const Artifact& artifact, const Delta& delta,
+                               const QString& then = QString());
+    static QString verifyAndCommit(const QString& sha);
+};
+
+#endif // ARTIFACTCACHE_H
@@ -8,6 +8,28 @@ struct HostConfig {
     QString address;
     QString sshUser;
     QString sshPass;
+    int sshPort = 22;
+
+    // Адрес с портом, если он нестандартный: различает несколько sshd на одном адресе
+    QString endpoint() const
+    {
+        return sshPort == 22 ? address : QString("%1:%2").arg(address).arg(sshPort);
+    }
 };
 
+// Путь Windows в виде, понятном WSL: C:\dir\file -> /mnt/c/dir/file
+inline QString toWslPath(const QString& windowsPath)
+{
+    QString wslPath = windowsPath;
+    wslPath.replace('\\', '/');
+
+    if (wslPath.contains(':')) {
+        QString driveLetter = wslPath.left(1).toLower();
+        wslPath = wslPath.mid(2);
+        wslPath = QString("/mnt/%1%2").arg(driveLetter, wslPath);
+    }
+
+    return wslPath;
+}
+
 #endif // COMMON_H
\ No newline at end of file
@@ -0,0 +1,60 @@
+#ifndef CONCURRENCYTUNER_H
+#define CONCURRENCYTUNER_H
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QVector>
+
+// Автоподбор параллельности (forks) по ходу выполнения.
+// Раз в интервал смотрит на задержку задач по хостам и загрузку CPU
+// управляющей машины: при перегрузке уменьшает параллельность,
+// при запасе - постепенно увеличивает (AIMD).
+class ConcurrencyTuner : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ConcurrencyTuner(QObject *parent = nullptr);
+
+    void setLimits(int minimum, int maximum);
+    void start(int initialConcurrency);
+    void stop();
+
+    int concurrency() const { return m_concurrency; }
+    // Лучшее значение за запуск - с него стоит начинать следующий
+    int recommendedConcurrency() const;
+
+    // Отметки о начале задачи на хосте и ее завершении
+    void taskStarted(const QString& host);
+    void taskFinished(const QString& host);
+    void addLatencySample(qint64 latencyMs);
+
+signals:
+    void concurrencyChanged(int concurrency);
+
+private slots:
+    void onSampleTimer();
+
+private:
+    double sampleCpuLoad();
+    qint64 medianLatency();
+
+    QTimer *m_sampleTimer;
+    QElapsedTimer m_clock;
+    QHash<QString, qint64> m_taskStartedAt;
+    QVector<qint64> m_latencySamples;
+
+    int m_concurrency;
+    int m_minimum;
+    int m_maximum;
+    int m_bestConcurrency;
+    qint64 m_baselineLatencyMs;
+
+    // Предыдущие счетчики CPU для расчета загрузки за интервал
+    quint64 m_lastIdleTime;
+    quint64 m_lastTotalTime;
+};
+
+#endif // CONCURRENCYTUNER_H
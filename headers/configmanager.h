@@ -17,6 +17,13 @@ public:
     void loadConfiguration(QList<HostConfig>& hosts, QString& defaultUser);
     void setConfigFilePath(const QString& path);
 
+    // Параметры параллельности, подобранные в прошлых запусках
+    void saveTuning(int concurrency, int batchSize);
+    void loadTuning(int& concurrency, int& batchSize);
+
+    // Шаблоны подсветки вывода (output/patterns в файле настроек)
+    QStringList loadOutputPatterns();
+
 private:
     QString configFilePath;
 };
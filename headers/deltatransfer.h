@@ -0,0 +1,39 @@
+#ifndef DELTATRANSFER_H
+#define DELTATRANSFER_H
+
+#include <QString>
+#include "artifactcache.h"
+
+// Блочная дельта-передача архива (по мотивам rsync).
+// Управляющая машина хранит версию архива, отправленную в прошлый раз;
+// при изменении файла новая версия сравнивается с ней скользящей
+// контрольной суммой, и на хост уходит только патч - сценарий bash,
+// который собирает новый blob из блоков базовой версии (dd) и вставок
+// (base64). Если базовой версии на хосте нет, архив передается целиком.
+class DeltaTransfer
+{
+public:
+    struct Stats {
+        int blockSize = 0;
+        qint64 copiedBytes = 0;
+        qint64 literalBytes = 0;
+        qint64 patchSize = 0;
+        qint64 elapsedMs = 0;
+    };
+
+    // Готовит патч от прошлой версии файла (если она есть и файл изменился)
+    // и запоминает текущую версию как базу для следующего запуска.
+    // patchDir - каталог запуска для патча (пустой - хранилище баз),
+    // summary - строка для журнала о результате сравнения
+    static ArtifactCache::Delta prepare(const ArtifactCache::Artifact& artifact, const QString& patchDir,
+                                        QString* summary = nullptr);
+
+    static bool buildPatch(const QString& basePath, const QString& baseSha,
+                           const QString& newPath, const QString& newSha,
+                           const QString& patchPath, Stats* stats = nullptr);
+
+    // Локальное хранилище базовых версий
+    static QString storeDir();
+};
+
+#endif // DELTATRANSFER_H
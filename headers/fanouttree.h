@@ -0,0 +1,37 @@
+#ifndef FANOUTTREE_H
+#define FANOUTTREE_H
+
+#include <QString>
+#include "common.h"
+
+// Раздача архива деревом: управляющая машина загружает его только на
+// несколько хостов-сидов, а те пересылают blob из своего кэша следующему
+// ярусу и т.д. Хосты нумеруются в порядке списка: первые degree - сиды,
+// у каждого узла до degree потомков. Каждый переход проверяется по SHA-256:
+// отправитель сверяет свой blob, получатель - принятые данные.
+class FanoutTree
+{
+public:
+    // degree = 0 - раздача деревом выключена
+    FanoutTree(int hostCount = 0, int degree = 0);
+
+    bool isEnabled() const;
+    // Индекс родителя; -1 - получает архив от управляющей машины
+    int parent(int index) const;
+    // Ярус хоста: 0 - сиды
+    int tier(int index) const;
+    // Число ярусов ретрансляции (без сидов)
+    int depth() const;
+
+    // Команда, выполняемая на родителе: blob из кэша родителя передается в
+    // childCommand на потомке. Потомок - только с ключом (агент, ssh -A):
+    // хосты с паролем через дерево не раздаются, их пароль не покидает
+    // управляющую машину. Код выхода 96 - blob родителя поврежден
+    static QString relayCommand(const HostConfig& child, const QString& sha, const QString& childCommand);
+
+private:
+    int m_hostCount;
+    int m_degree;
+};
+
+#endif // FANOUTTREE_H
@@ -0,0 +1,112 @@
+#ifndef LINEFRAMER_H
+#define LINEFRAMER_H
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QIODevice>
+#include <cstring>
+
+// Нарезка потока байтов на строки без лишних копий.
+// Данные читаются из устройства прямо в переиспользуемый буфер, каждая
+// полная строка передается обработчику как QByteArray::fromRawData - вид
+// на буфер без копирования (без '\n' и завершающего '\r'). Незавершенная
+// строка остается в буфере до следующего чтения, поэтому маркеры,
+// разрезанные границей чтения, не теряются.
+// Вид действителен только внутри вызова обработчика.
+class LineFramer
+{
+public:
+    explicit LineFramer(int initialCapacity = 64 * 1024);
+
+    // Прочитать все доступное из текущего канала устройства
+    template<typename Handler>
+    void readFrom(QIODevice *device, Handler handler)
+    {
+        qint64 available = device->bytesAvailable();
+        if (available <= 0) return;
+
+        QElapsedTimer timer;
+        timer.start();
+
+        reserve(int(available));
+        qint64 read = device->read(m_buffer.data() + m_end, available);
+        if (read > 0) {
+            m_end += int(read);
+            m_totalBytes += read;
+            drain(handler);
+        }
+        m_busyNsecs += timer.nsecsElapsed();
+    }
+
+    template<typename Handler>
+    void append(const char *data, int size, Handler handler)
+    {
+        if (size <= 0) return;
+
+        QElapsedTimer timer;
+        timer.start();
+
+        reserve(size);
+        std::memcpy(m_buffer.data() + m_end, data, size_t(size));
+        m_end += size;
+        m_totalBytes += size;
+        drain(handler);
+        m_busyNsecs += timer.nsecsElapsed();
+    }
+
+    // Отдать остаток без перевода строки (при завершении процесса)
+    template<typename Handler>
+    void flush(Handler handler)
+    {
+        if (m_begin < m_end) {
+            int length = m_end - m_begin;
+            if (m_buffer.at(m_end - 1) == '\r') --length;
+            handler(QByteArray::fromRawData(m_buffer.constData() + m_begin, length));
+        }
+        clear();
+    }
+
+    // Сбросить буфер (статистика сохраняется)
+    void clear();
+
+    bool hasPartialLine() const { return m_begin < m_end; }
+    qint64 totalBytes() const { return m_totalBytes; }
+    // Время в readFrom/append вместе с обработчиком - для оценки МБ/с
+    qint64 busyNsecs() const { return m_busyNsecs; }
+
+private:
+    template<typename Handler>
+    void drain(Handler& handler)
+    {
+        const char *base = m_buffer.constData();
+        while (m_scan < m_end) {
+            const char *newline = static_cast<const char*>(std::memchr(base + m_scan, '\n', size_t(m_end - m_scan)));
+            if (!newline) {
+                m_scan = m_end;
+                break;
+            }
+
+            int lineEnd = int(newline - base);
+            int length = lineEnd - m_begin;
+            if (length > 0 && base[lineEnd - 1] == '\r') --length;
+            handler(QByteArray::fromRawData(base + m_begin, length));
+            m_begin = m_scan = lineEnd + 1;
+        }
+
+        if (m_begin == m_end) {
+            m_begin = m_scan = m_end = 0;
+        }
+    }
+
+    // Освободить место под size байт: сдвинуть хвост в начало или вырастить буфер
+    void reserve(int size);
+
+    QByteArray m_buffer;
+    int m_begin;  // начало незавершенной строки
+    int m_scan;   // до этой позиции перевода строки нет
+    int m_end;    // конец данных
+    qint64 m_totalBytes;
+    qint64 m_busyNsecs;
+};
+
+#endif // LINEFRAMER_H
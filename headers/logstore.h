@@ -0,0 +1,69 @@
+#ifndef LOGSTORE_H
+#define LOGSTORE_H
+
+#include <QList>
+#include <QString>
+#include <QTemporaryFile>
+#include <QVector>
+
+// Хранилище журнала запуска с ограниченной памятью.
+// Строки копятся страницами фиксированного размера; в памяти держится
+// только несколько последних страниц, более старые сжимаются и
+// дописываются во временный файл. При прокрутке назад страница читается
+// с диска в небольшой кэш. Память не растет с длиной запуска - растет
+// только индекс смещений (16 байт на страницу).
+// Без выгрузки на диск хранилище ограничено: старые страницы отбрасываются.
+class LogStore
+{
+public:
+    enum class Style : quint8 {
+        Normal,
+        Error,      // ошибки и fatal - красным
+        Highlight   // совпадение с пользовательским шаблоном
+    };
+
+    struct Line {
+        QString text;
+        Style style = Style::Normal;
+    };
+
+    explicit LogStore(int pageLines = 2048, int memoryPages = 8, bool spillToDisk = true);
+
+    void append(const QString& text, Style style = Style::Normal);
+    void clear();
+
+    // Число доступных строк (без отброшенных)
+    qint64 lineCount() const { return m_lineCount; }
+    // Сквозной номер первой доступной строки: сколько строк отброшено
+    qint64 firstLine() const { return m_droppedPages * m_pageLines; }
+    // Строка по номеру среди доступных; страница с диска подгружается в кэш
+    Line line(qint64 index);
+
+    qint64 spilledBytes() const { return m_spillSize; }
+
+private:
+    struct SpilledPage {
+        qint64 offset;
+        qint64 size;
+    };
+
+    void spillOldest();
+    const QVector<Line>& cachedPage(qint64 page);
+
+    int m_pageLines;
+    int m_memoryPages;
+    bool m_spillToDisk;
+    qint64 m_lineCount;
+    qint64 m_droppedPages;
+
+    // Страницы в памяти: первая имеет номер m_droppedPages + m_spilled.size()
+    QList<QVector<Line>> m_pages;
+    QVector<SpilledPage> m_spilled;
+    QTemporaryFile m_spillFile;
+    qint64 m_spillSize;
+
+    // Прочитанные с диска страницы, последняя - самая свежая
+    QList<QPair<qint64, QVector<Line>>> m_cache;
+};
+
+#endif // LOGSTORE_H
@@ -0,0 +1,77 @@
+#ifndef LOGVIEW_H
+#define LOGVIEW_H
+
+#include <QAbstractScrollArea>
+#include <QHash>
+#include <QStringList>
+#include <QVector>
+#include "logstore.h"
+
+// Окно журнала запуска: рисует только видимые строки из LogStore,
+// поэтому добавление строки стоит O(1) независимо от длины журнала,
+// а прокрутка доступна по всей истории. Пока полоса прокрутки внизу,
+// окно следует за новыми строками.
+// Кроме общего журнала ведутся журналы хостов: ограниченный буфер на хост
+// с индексом задач. Переключение между ними только меняет источник строк.
+class LogView : public QAbstractScrollArea
+{
+    Q_OBJECT
+
+public:
+    // Начало задачи в журнале хоста
+    struct TaskMark {
+        QString task;
+        qint64 line;  // сквозной номер строки (см. LogStore::firstLine)
+    };
+
+    explicit LogView(QWidget *parent = nullptr);
+    ~LogView();
+
+    // Строки в формате прежнего QTextEdit: span с цветом распознается
+    // и превращается в стиль строки
+    void appendLine(const QString& text);
+    void appendLines(const QStringList& lines);
+    void appendHostLine(const QString& host, const QString& task, const QString& text);
+    void clear();
+
+    // Пустая строка - общий журнал
+    void setCurrentHost(const QString& host);
+    QString currentHost() const { return m_currentHost; }
+    QVector<TaskMark> tasks(const QString& host) const;
+    // Прокрутить журнал текущего хоста к началу задачи
+    void scrollToTask(int index);
+
+    qint64 lineCount() const { return m_current->lineCount(); }
+
+signals:
+    void hostAdded(const QString& host);
+    void taskAdded(const QString& host, const QString& task);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+
+private:
+    struct HostLog {
+        LogStore store;
+        QVector<TaskMark> tasks;
+        int maxLineLength = 0;
+
+        HostLog();
+    };
+
+    void appendParsed(LogStore& store, int& maxLineLength, const QString& text);
+    void updateScrollBars();
+    int visibleRows() const;
+    bool isFollowing() const;
+    void refresh(bool follow);
+
+    LogStore m_store;
+    int m_maxLineLength;
+    QHash<QString, HostLog*> m_hosts;
+    QString m_currentHost;
+    LogStore *m_current;
+    int *m_currentMaxLength;
+};
+
+#endif // LOGVIEW_H
@@ -3,7 +3,7 @@
 
 #include <QMainWindow>
 #include "configmanager.h"
-#include "ansiblerunner.h"
+#include "runqueue.h"
 #include "windowgraphics.h"
 #include "wslchecker.h"
 #include <QDragEnterEvent>
@@ -30,12 +30,20 @@ private slots:
     void onAddHostClicked();
     void removeHost();
     void onPlayButtonClicked();
-    void onAnsibleOutput(const QString& text);
-    void onAnsibleFinished(bool success, int exitCode);
+    void onRunJobChanged(int jobId);
+    void onRunQueueIdle();
+    void onCancelRunClicked();
+    void onRetryFailedClicked();
     void onAnsibleError(const QString& message);
     void onWslCheckCompleted(const WSLChecker::WSLInfo &info);
     void onWslCheckError(const QString &error);
     void onWslSetupFinished(bool success);
+    void onConnectionStateChanged(const QString& endpoint, const QString& stateText);
+    void onHostProgressChanged(const QString& endpoint, int percent);
+    void onHostEtaChanged(const QString& endpoint, qint64 remainingMs, bool slow);
+    void onHostReachability(const QString& endpoint, bool reachable, qint64 latencyMs);
+    void onScriptStaged(bool success, const QString& scriptPath, const QString& archivePath);
+    void onArchiveStaged(bool success, const QString& archivePath);
 
 private:
     void setupConnections();
@@ -44,16 +52,29 @@ private:
     void updatePlayButtonState();
     void checkWSLAndShowStatus();
     void showMessage(const QString &message, bool isError = false);
+    void refreshHostStatus(const QString& endpoint);
     bool wslCheckPerformed = false;
     Ui::MainWindow *ui;
     WindowGraphics *graphics;
     ConfigManager *configManager;
-    AnsibleRunner *ansibleRunner;
+    // Запуски: очередь, каждый в своем рабочем потоке (runqueue.h)
+    RunQueue *runQueue;
     WSLChecker *checker;
     QString currentFilePath;
     QList<HostConfig> hostsConfig;
     QString playbookPath;
     QString currentArchivePath;
+    // Имя файла, поданного на подготовку, - для подписи после scriptStaged
+    QString pendingScriptName;
+    // Имя подготовленного скрипта - подпись запуска в очереди
+    QString currentScriptName;
+    // Статус хоста в списке: состояние подключения и прогресс запуска
+    QHash<QString, QString> hostConnectionStates;
+    QHash<QString, int> hostProgress;
+    // Оставшееся время хоста и признак "медленнее обычного"
+    QHash<QString, QPair<qint64, bool>> hostEta;
+    // Последняя проверка доступности: время подключения, -1 - порт не ответил
+    QHash<QString, qint64> hostReachability;
 };
 
 #endif // MAINWINDOW_H
@@ -0,0 +1,75 @@
+#ifndef OUTPUTMATCHER_H
+#define OUTPUTMATCHER_H
+
+#include <QByteArray>
+#include <QStringList>
+#include <QVector>
+
+// Классификация строк вывода Ansible за один проход.
+// Все шаблоны (заголовки задач, PLAY RECAP, fatal/unreachable, служебные
+// маркеры и шаблоны пользователя) собираются в автомат Ахо-Корасик, поэтому
+// время разбора строки линейно по ее длине и не зависит от числа шаблонов -
+// это важно для многомегабайтного вывода -vvv.
+class OutputMatcher
+{
+public:
+    enum Category : quint32 {
+        TaskHeader  = 1u << 0,  // TASK [...]
+        PlayRecap   = 1u << 1,  // PLAY RECAP
+        Fatal       = 1u << 2,  // fatal: [host]
+        Unreachable = 1u << 3,  // UNREACHABLE!
+        Failed      = 1u << 4,  // FAILED!
+        Warning     = 1u << 5,  // [WARNING]
+        CasStats    = 1u << 6,  // @@CAS-STATS (artifactcache.h)
+        BundleStep  = 1u << 7,  // @@STEP (remotebundle.h)
+        UserPattern = 1u << 8   // один из пользовательских шаблонов
+    };
+
+    // Не больше 64 пользовательских шаблонов - их совпадения отдаются битовой маской
+    static const int maxUserPatterns = 64;
+
+    OutputMatcher();
+
+    // anchored - шаблон должен стоять в начале строки
+    void addPattern(const QByteArray& pattern, quint32 category, bool anchored = false);
+    // Возвращает номер пользовательского шаблона или -1, если лимит исчерпан
+    int addUserPattern(const QByteArray& pattern);
+    void build();
+
+    // Категории строки; userMatches - биты совпавших пользовательских шаблонов
+    quint32 classify(const char *data, int size, quint64 *userMatches = nullptr) const;
+
+    int userPatternCount() const { return m_userPatterns.size(); }
+    QByteArray userPattern(int index) const { return m_userPatterns.value(index); }
+
+    qint64 scannedBytes() const { return m_scannedBytes; }
+    qint64 busyNsecs() const { return m_busyNsecs; }
+
+    // Стандартный набор шаблонов вывода ansible-playbook плюс шаблоны пользователя
+    static OutputMatcher forAnsible(const QStringList& userPatterns);
+
+private:
+    struct Pattern {
+        QByteArray text;
+        quint32 category;
+        bool anchored;
+        int userIndex;
+    };
+
+    int addState(int depth);
+
+    QVector<Pattern> m_patterns;
+    QList<QByteArray> m_userPatterns;
+
+    // Детерминированный автомат: 256 переходов на состояние
+    QVector<int> m_next;
+    QVector<int> m_depth;
+    QVector<quint32> m_output;          // шаблоны в любом месте строки (с учетом суффиксных ссылок)
+    QVector<quint32> m_anchoredOutput;  // шаблоны, которые должны начинаться с позиции 0
+    QVector<quint64> m_userOutput;
+
+    mutable qint64 m_scannedBytes;
+    mutable qint64 m_busyNsecs;
+};
+
+#endif // OUTPUTMATCHER_H
@@ -0,0 +1,31 @@
+#ifndef PROCESSTREE_H
+#define PROCESSTREE_H
+
+#include <QProcess>
+#include <QString>
+#include <QStringList>
+#include "common.h"
+
+// Дерево процессов внутри WSL.
+// wsl.exe - только посредник: его завершение не останавливает ansible-playbook,
+// его рабочие процессы и ssh в Linux. Поэтому команда запускается в своей
+// сессии (setsid), а номер ее группы пишется в pid-файл. Остановка посылает
+// SIGTERM группе и всем потомкам, через паузу - SIGKILL, и только после
+// этого добивает сам wsl.exe. Ничего не ждет: эскалация выполняется
+// отдельным процессом в WSL, а не в потоке вызывающего.
+class ProcessTree
+{
+public:
+    // Аргументы wsl для запуска command в отдельной группе процессов;
+    // pidFile - путь Windows, в него пишется номер группы
+    static QStringList wrap(const QString& pidFile, const QStringList& command);
+
+    // Асинхронная остановка дерева: SIGTERM, через graceMs SIGKILL, затем
+    // kill() процесса wsl.exe, если он еще не вышел. pid-файл удаляется
+    static void terminate(QProcess *process, const QString& pidFile, int graceMs = 3000);
+
+    // Удаляет pid-файл после обычного завершения процесса
+    static void release(const QString& pidFile);
+};
+
+#endif // PROCESSTREE_H
@@ -22,12 +22,20 @@ public:
     
     void setProgressBar(QProgressBar* progressBar);
     void setErrorMode(bool isError);
+    // м:сс или ч:мм:сс
+    static QString formatDuration(qint64 msecs);
 public slots:
     void startProgress(int maxSteps = 100);
     void stopProgress(bool success = true);
     void updateProgress(int step, const QString& stepDescription = QString());
     void incrementProgress(const QString& stepDescription = QString());
     void setStatusText(const QString& text);
+    // Доля выполненных задач на отдельном хосте (address:port)
+    void updateHostProgress(const QString& endpoint, int percent);
+    // Оставшееся время хоста по истории его задач; slow - хост идет медленнее обычного
+    void updateHostEta(const QString& endpoint, qint64 remainingMs, bool slow);
+    // Оставшееся время запуска; -1 - оценить по прошедшему времени и проценту
+    void setEta(qint64 remainingMs);
     void reset();
 
 private slots:
@@ -54,6 +62,9 @@ signals:
     void runningStateChanged(bool running);
     void progressCompleted(bool success);
     void stepReached(int step, const QString& description);
+    void hostProgressChanged(const QString& endpoint, int percent);
+    void hostEtaChanged(const QString& endpoint, qint64 remainingMs, bool slow);
+    void etaChanged(qint64 remainingMs);
 };
 
 #endif // PROGRESSMANAGER_H
\ No newline at end of file
@@ -0,0 +1,107 @@
+#ifndef PROGRESSMODEL_H
+#define PROGRESSMODEL_H
+
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+// Модель прогресса запуска: хосты x задачи playbook.
+// Список задач берется из самого playbook (разбирается один раз и
+// кэшируется до изменения файла), вес задачи - ее средняя длительность
+// в прошлых запусках, поэтому долгие шаги (копирование, выполнение
+// скрипта) двигают прогресс сильнее коротких.
+// Для каждого хоста отдельно хранится история задач (скользящие среднее и
+// дисперсия): по ней считается оставшееся время хоста и отмечаются хосты,
+// которые идут заметно медленнее своих же прошлых запусков.
+class ProgressModel
+{
+public:
+    ProgressModel();
+
+    // Загрузить план задач; false - в playbook не найдено ни одной задачи
+    bool load(const QString& playbookPath);
+    QStringList tasks() const { return m_tasks; }
+
+    // Начало запуска: список хостов (имена из inventory)
+    void reset(const QStringList& hosts);
+
+    // Задача началась на хосте (событие host_start)
+    void hostTaskStarted(const QString& host, const QString& task);
+    // Результат задачи на хосте (ok, failed, skipped, unreachable)
+    void hostResult(const QString& host, const QString& task, qint64 durationMs);
+    // Хост закончил playbook (или выбыл) - оставшиеся задачи засчитываются
+    void hostFinished(const QString& host);
+
+    int percent() const;
+    int hostPercent(const QString& host) const;
+
+    QStringList hosts() const { return m_done.keys(); }
+    // Оценка оставшегося времени хоста, мс (0 - хост закончил)
+    qint64 hostRemainingMs(const QString& host) const;
+    // Оставшееся время запуска: хосты идут параллельно, считаем по самому долгому
+    qint64 remainingMs() const;
+    // Задача, которая на хосте идет (или шла) намного дольше обычного для него;
+    // пустая строка - хост в норме
+    QString slowTask(const QString& host) const;
+    // Ожидаемая длительность задачи на хосте по его истории, мс
+    qint64 expectedMs(const QString& host, const QString& task) const;
+
+    // Запомнить длительности задач этого запуска для весов следующих
+    void saveDurations();
+
+private:
+    struct Plan {
+        QDateTime modified;
+        qint64 size = 0;
+        QStringList tasks;
+    };
+
+    // Скользящие среднее и дисперсия длительности задачи на хосте
+    struct Estimate {
+        double mean = 0.0;
+        double variance = 0.0;
+        int samples = 0;
+
+        void add(double value);
+        // Длительность, после которой задача считается аномально долгой
+        double slowThreshold() const;
+    };
+
+    struct HostRun {
+        QVector<Estimate> history;  // по индексам m_tasks
+        QHash<int, qint64> observed; // длительности этого запуска
+        int currentTask = -1;
+        qint64 currentStart = 0;
+        QString slowTask;
+    };
+
+    static QStringList parseTasks(const QString& playbookPath);
+    static QString durationsPath();
+    static QString hostDurationsPath();
+    void loadWeights();
+    void loadHostHistory();
+    double expected(const HostRun& run, int task) const;
+
+    QString m_playbookName;
+    QStringList m_tasks;
+    QHash<QString, int> m_taskIndex;
+    QVector<double> m_weights;
+    double m_totalWeight;
+
+    QHash<QString, QVector<bool>> m_done;
+    QHash<QString, double> m_doneWeight;
+    double m_doneTotal;
+
+    // Наблюдения текущего запуска: сумма длительностей и число хостов
+    QHash<QString, QPair<qint64, int>> m_observed;
+
+    QHash<QString, HostRun> m_hostRuns;
+    QElapsedTimer m_clock;
+
+    static QHash<QString, Plan> s_plans;
+};
+
+#endif // PROGRESSMODEL_H
@@ -0,0 +1,76 @@
+#ifndef REACHABILITYPROBER_H
+#define REACHABILITYPROBER_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QElapsedTimer>
+#include <QTimer>
+#include "common.h"
+
+class QTcpSocket;
+
+// Предварительная проверка доступности хостов перед запуском.
+// К SSH-порту каждого хоста открывается неблокирующее TCP-подключение;
+// все подключения обслуживает событийный цикл потока-владельца (без потока
+// на хост), одновременно открыто не больше maxInFlight, срок у каждого
+// короткий и проверяется одним общим таймером. Хост, не принявший
+// подключение за срок, не стоит полного ConnectTimeout ssh внутри запуска.
+class ReachabilityProber : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Result {
+        bool reachable = false;
+        // Время установления TCP-подключения; -1 - не подключились
+        qint64 latencyMs = -1;
+        QString error;
+    };
+
+    explicit ReachabilityProber(QObject *parent = nullptr);
+    ~ReachabilityProber();
+
+    // Срок подключения к одному хосту, мс (включая разрешение имени)
+    void setTimeout(int ms);
+    void setMaxInFlight(int count);
+
+    // Хосты с одинаковым address:port проверяются один раз
+    void start(const QList<HostConfig>& hosts);
+    void abort();
+    bool isRunning() const { return m_running; }
+
+    // address:port -> итог проверки
+    const QHash<QString, Result>& results() const { return m_results; }
+
+signals:
+    void hostProbed(const QString& endpoint, bool reachable, qint64 latencyMs);
+    void finished();
+
+private slots:
+    void onConnected();
+    void onSocketError();
+    void checkDeadlines();
+
+private:
+    struct Probe {
+        QString endpoint;
+        QTcpSocket *socket = nullptr;
+        QElapsedTimer timer;
+    };
+
+    void launchNext();
+    void complete(QTcpSocket *socket, bool reachable, const QString& error);
+    int findProbe(QTcpSocket *socket) const;
+
+    QList<HostConfig> m_targets;
+    int m_nextTarget;
+    QList<Probe> m_inFlight;
+    QHash<QString, Result> m_results;
+    QTimer *m_deadlineTimer;
+    int m_timeoutMs;
+    int m_maxInFlight;
+    bool m_running;
+};
+
+#endif // REACHABILITYPROBER_H
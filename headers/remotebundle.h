@@ -0,0 +1,65 @@
+#ifndef REMOTEBUNDLE_H
+#define REMOTEBUNDLE_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+
+// Сценарий bash, который выполняет на хосте все шаги ansible.yml
+// (подготовка скрипта, распаковка, запуск, сохранение результатов)
+// за одно обращение по SSH. Сценарий может прийти через stdin (bash -s),
+// поэтому скрипт пользователя запускается с stdin из /dev/null.
+// Каждый шаг печатает строки
+//   @@STEP start <id>
+//   @@STEP end <id> <код> <мс>
+// а в конце выводится итоговая строка
+//   @@BUNDLE-RESULT {"host": ..., "rc": ..., "steps": [...]}
+class RemoteBundle
+{
+public:
+    struct StepStatus {
+        QString id;
+        bool finished = false;
+        int exitCode = 0;
+        qint64 durationMs = 0;
+    };
+
+    RemoteBundle();
+
+    // Содержимое скрипта встраивается в сценарий (base64);
+    // если не задано - ожидается, что скрипт уже скопирован на хост
+    void setScriptContent(const QByteArray& script);
+    // Имя архива на управляющей машине (для каталога распаковки)
+    void setArchiveName(const QString& archiveName);
+    // Архив уже распакован потоковой передачей - шаг распаковки пропускается,
+    // в отчет попадает манифест, записанный при приеме потока
+    void setArchiveStreamed(bool streamed);
+
+    QString build() const;
+    QStringList stepIds() const;
+
+    static QString stepTitle(const QString& id);
+    static bool parseStepLine(const QString& line, StepStatus& status);
+
+    // Каталог распаковки архива на хосте
+    static QString extractDirFor(const QString& archiveName);
+    // Ключи tar для распаковки архива (по расширению)
+    static QString tarExtractFlags(const QString& archiveName);
+    // Можно ли распаковывать архив из потока (tar, tar.gz, tgz)
+    static bool canStream(const QString& archiveName);
+    // Удаленная команда записи манифеста распакованного архива (число файлов
+    // и размер) в <каталог>.manifest с выводом его одной строкой. Не содержит $
+    // и двойных кавычек, поэтому проходит через wsl и ssh без доп. экранирования
+    static QString manifestCommand(const QString& archiveName);
+
+    static const char *scriptDest;
+    static const char *archiveDest;
+    static const char *resultDir;
+
+private:
+    QByteArray m_scriptContent;
+    QString m_archiveName;
+    bool m_archiveStreamed = false;
+};
+
+#endif // REMOTEBUNDLE_H
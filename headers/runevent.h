@@ -0,0 +1,39 @@
+#ifndef RUNEVENT_H
+#define RUNEVENT_H
+
+#include <QString>
+
+// Событие рабочего потока запуска для GUI (runworker.h).
+// Поля используются в зависимости от типа.
+struct RunEvent
+{
+    enum class Type {
+        None,
+        Output,           // text - строка журнала
+        HostOutput,       // host, task, text - строка журнала хоста
+        Error,            // text - сообщение об ошибке
+        Status,           // text - строка состояния
+        Progress,         // value - процент
+        HostProgress,     // host, value - процент хоста
+        HostEta,          // host, value - оставшиеся мс, success - хост медленнее обычного
+        Eta,              // value - оставшиеся мс запуска
+        RunningChanged,   // success - запуск начат (true) или остановлен
+        ProgressFinished, // success - итог для полосы прогресса
+        Reachability,     // host, success - порт SSH отвечает, value - мс подключения
+        Tuning,           // value - параллельность, extra - размер партии
+        ScriptStaged,     // success; text - путь к скрипту, host - найденный архив
+        ArchiveStaged,    // success; text - путь к архиву
+        HostResult,       // host, task, value - итог хоста (AnsibleRunner::HostOutcome)
+        Finished          // success, value - код завершения
+    };
+
+    Type type = Type::None;
+    QString text;
+    QString host;
+    QString task;
+    int value = 0;
+    int extra = 0;
+    bool success = false;
+};
+
+#endif // RUNEVENT_H
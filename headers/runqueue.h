@@ -0,0 +1,165 @@
+#ifndef RUNQUEUE_H
+#define RUNQUEUE_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QSet>
+#include "runworker.h"
+
+// Очередь запусков.
+// Каждый запуск выполняется своим RunWorker (отдельный поток, AnsibleRunner
+// и контроллер Ansible) в собственном каталоге подготовки: inventory,
+// bundle, патчи и копия скрипта не пересекаются с другими запусками.
+// Одновременно идет не больше maxConcurrent запусков; запуски с общими
+// хостами выполняются строго по очереди (на хосте общие /tmp-пути),
+// остальные могут обгонять заблокированные. Прогресс каждого запуска
+// копится в своем ProgressManager, в общую полосу идет сводный.
+// Итоги хостов запоминаются в записи запуска; хосты с ошибкой или
+// недоступные перезапускаются отдельным inventory (автоматически с
+// экспоненциальной паузой или по команде), и их новые итоги заменяют
+// прежние в той же записи.
+// Канареечный запуск: сначала canarySize хостов, затем остальные волнами
+// по batchSize. После каждой волны проверяется доля хостов с ошибкой; выше
+// порога maxFailPercent оставшиеся хосты не запускаются (автомат
+// отключения) и записываются как "не запускался" - их можно продолжить
+// тем же повтором по команде.
+// Пул мастер-подключений SSH один на очередь: все исполнители ходят через
+// общие сокеты, и состояние каждого хоста сообщает один владелец.
+class RunQueue : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum class State {
+        Queued,
+        Running,
+        RetryWaiting,   // пауза перед автоматическим повтором
+        Succeeded,
+        Failed,
+        Cancelled
+    };
+
+    struct Job {
+        int id = 0;
+        // Подпись в списке (имя исходного скрипта)
+        QString label;
+        RunSettings settings;
+        // Все хосты запуска; в settings.hosts - хосты текущей попытки
+        QList<HostConfig> allHosts;
+        QHash<QString, QPair<AnsibleRunner::HostOutcome, QString>> results;
+        int attempt = 0;
+        int autoRetries = 0;
+        // Хосты следующих волн канареечного запуска
+        QList<HostConfig> pending;
+        int wave = 0;
+        bool tripped = false;
+        // Входит в текущую серию запусков (сводный прогресс)
+        bool inBatch = true;
+        State state = State::Queued;
+        int percent = 0;
+        QString status;
+        qint64 etaMs = -1;
+        bool cancelRequested = false;
+        QSet<QString> endpoints;
+        RunWorker *worker = nullptr;
+        // Прогресс запуска и объединение его обновлений за кадр
+        ProgressManager *progress = nullptr;
+        UpdateCoalescer *updates = nullptr;
+    };
+
+    explicit RunQueue(QObject *parent = nullptr);
+    ~RunQueue();
+
+    // Общая полоса прогресса окна
+    void setProgressManager(ProgressManager *manager);
+    void setPlaybookPath(const QString& path);
+    void setRecordedConcurrency(int concurrency);
+    void warmUpController();
+    void setMaxConcurrent(int count);
+    int maxConcurrent() const { return m_maxConcurrent; }
+    // Автоматические повторы хостов с ошибкой: число попыток (0 - выключено)
+    // и пауза перед первой, дальше она удваивается
+    void setRetryPolicy(int maxRetries, int baseDelayMs = 5000);
+
+    // Ставит запуск в очередь; скрипт сразу конвертируется в каталог запуска,
+    // поэтому следующий перетащенный скрипт на него не влияет. Возвращает номер
+    // или -1, если копию скрипта записать не удалось
+    int enqueue(RunSettings settings, const QString& label = QString());
+    void cancel(int jobId);
+    void cancelAll();
+    // Перезапуск только хостов с ошибкой, недоступных, превысивших время и не запускавшихся
+    // (продолжение после автомата отключения); false - таких нет
+    bool retryFailed(int jobId);
+
+    const Job *job(int jobId) const;
+    int activeCount() const;
+    bool isIdle() const { return activeCount() == 0; }
+    static QString stateText(State state);
+    QString describe(const Job& job) const;
+    static QList<HostConfig> failedHosts(const Job& job, bool includeNotStarted = false);
+
+    // Подготовка файлов идет в отдельном рабочем потоке, не занятом запусками
+    void stageScript(const QString& path);
+    void stageArchive(const QString& path);
+
+signals:
+    // Вывод подготовки файлов (вне запусков)
+    void outputReceived(const QString& text);
+    // Пачка строк журнала запуска, в многопоточном режиме с префиксом [#N]
+    void linesReady(const QStringList& lines);
+    void hostOutputReceived(const QString& endpoint, const QString& task, const QString& text);
+    void errorOccurred(const QString& error);
+    void tuningRecorded(int concurrency, int batchSize);
+    void connectionStateChanged(const QString& endpoint, const QString& stateText);
+    void hostReachability(const QString& endpoint, bool reachable, qint64 latencyMs);
+    void hostProgressChanged(const QString& endpoint, int percent);
+    void hostEtaChanged(const QString& endpoint, qint64 remainingMs, bool slow);
+    void scriptStaged(bool success, const QString& scriptPath, const QString& archivePath);
+    void archiveStaged(bool success, const QString& archivePath);
+    void jobChanged(int jobId);
+    void jobFinished(int jobId, bool success);
+    // Старый завершенный запуск убран из списка
+    void jobRemoved(int jobId);
+    // Очередь опустела: все запуски завершены
+    void idle();
+
+private:
+    Job *findJob(int jobId);
+    Job *findJobByWorker(RunWorker *worker);
+    RunWorker *acquireWorker();
+    void connectWorker(RunWorker *worker);
+    void startJob(Job& job);
+    void finishJob(Job& job, bool success);
+    // retry - повтор хостов с ошибкой; иначе следующая волна
+    void requeue(Job& job, const QList<HostConfig>& hosts, int delayMs, bool retry = true);
+    // Доля хостов с ошибкой среди выполнявших скрипт превысила порог;
+    // deferred - сколько хостов отложено проверкой доступности (в долю не входят)
+    bool breakerTripped(const Job& job, int *failPercent, int *deferred = nullptr) const;
+    QList<HostConfig> takeWave(Job& job) const;
+    qint64 backoffMs(int retry) const;
+    // Каталог запуска после окончания: скрипт остается для повтора по команде
+    void releaseStaging(const Job& job, bool keepScript);
+    void schedule();
+    void updateAggregate();
+    QString tagLine(const Job& job, const QString& text) const;
+    QString stagingDirFor(int jobId) const;
+
+    QList<Job> m_jobs;
+    QList<RunWorker*> m_workers;
+    QList<RunWorker*> m_idleWorkers;
+    RunWorker *m_stager;
+    SshConnectionPool *m_connectionPool;
+    ProgressManager *m_progressManager;
+    QString m_playbookPath;
+    int m_recordedConcurrency;
+    bool m_warm;
+    int m_maxConcurrent;
+    int m_nextId;
+    int m_maxRetries;
+    int m_retryBaseDelayMs;
+    // Итог серии запусков (с момента, когда очередь была пуста) для общей полосы
+    bool m_batchFailed;
+};
+
+#endif // RUNQUEUE_H
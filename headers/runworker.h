@@ -0,0 +1,110 @@
+#ifndef RUNWORKER_H
+#define RUNWORKER_H
+
+#include <QMutex>
+#include <QObject>
+#include <QThread>
+#include <QTimer>
+#include <QWaitCondition>
+#include <atomic>
+#include "ansiblerunner.h"
+#include "progressmanager.h"
+#include "updatecoalescer.h"
+#include "runevent.h"
+#include "spscqueue.h"
+
+// Параметры одного запуска, собранные в GUI
+struct RunSettings
+{
+    QList<HostConfig> hosts;
+    QString scriptPath;
+    QString archivePath;
+    // Каталог файлов запуска (runqueue.h); пустой - рядом с программой
+    QString stagingDir;
+    int batchSize = 0;
+    int forks = 0;
+    int fanoutDegree = 0;
+    // Канареечный запуск (runqueue.h): сначала canarySize хостов, затем
+    // остальные; при доле ошибок выше maxFailPercent оставшиеся не запускаются
+    int canarySize = 0;
+    int maxFailPercent = 100;
+    // Пределы времени задачи и хоста, секунды (0 - без предела)
+    int taskTimeoutSec = 0;
+    int hostTimeoutSec = 0;
+    // Срок проверки доступности SSH-порта перед запуском, мс (0 - без проверки)
+    int preflightTimeoutMs = 0;
+    bool fusedMode = false;
+    bool streamArchive = false;
+    bool liveOutput = false;
+    QStringList outputPatterns;
+    AnsibleRunner::Engine engine = AnsibleRunner::Engine::AnsiblePlaybook;
+};
+
+// Запуск развертывания в отдельном потоке.
+// AnsibleRunner со всеми процессами, разбором вывода и подготовкой файлов
+// живет в рабочем потоке; команды GUI передаются туда очередью событий Qt,
+// а результаты возвращаются типизированными RunEvent через очередь
+// SPSC без блокировок. GUI забирает события по своему таймеру, поэтому
+// поток вывода любого объема не блокирует окно.
+class RunWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit RunWorker(QObject *parent = nullptr);
+    ~RunWorker();
+
+    // Через него события прогресса попадают в полосу прогресса GUI
+    void setUpdateCoalescer(UpdateCoalescer *updates);
+
+    void setPlaybookPath(const QString& path);
+    void setRecordedConcurrency(int concurrency);
+    void warmUpController();
+    void setConnectionPool(SshConnectionPool *pool);
+
+    void start(const RunSettings& settings);
+    void stop();
+
+    // Подготовка файлов в рабочем потоке: проверка скрипта и поиск архива
+    // рядом с ним (конвертация - при постановке запуска в очередь). Пути в playbook не пишутся - раннер передает их через -e.
+    // Результат - scriptStaged/archiveStaged
+    void stageScript(const QString& path);
+    void stageArchive(const QString& path);
+
+signals:
+    void outputReceived(const QString& text);
+    void hostOutputReceived(const QString& endpoint, const QString& task, const QString& text);
+    void errorOccurred(const QString& error);
+    void finished(bool success, int exitCode);
+    void tuningRecorded(int concurrency, int batchSize);
+    void hostResult(const QString& endpoint, AnsibleRunner::HostOutcome outcome, const QString& task);
+    void hostReachability(const QString& endpoint, bool reachable, qint64 latencyMs);
+    void scriptStaged(bool success, const QString& scriptPath, const QString& archivePath);
+    void archiveStaged(bool success, const QString& archivePath);
+
+private slots:
+    void drainEvents();
+
+private:
+    // Только из рабочего потока
+    void post(RunEvent event);
+    void post(RunEvent::Type type, const QString& text = QString(), int value = 0, bool success = false);
+    void connectProducer();
+    void dispatch(const RunEvent& event);
+
+    QThread m_thread;
+    AnsibleRunner *m_runner;
+    // Копия менеджера прогресса в рабочем потоке: его сигналы становятся событиями
+    ProgressManager *m_workerProgress;
+    UpdateCoalescer *m_updates;
+
+    SpscQueue<RunEvent> m_queue;
+    QTimer m_drainTimer;
+    std::atomic<bool> m_shuttingDown;
+    // Очередь заполнена: рабочий поток спит, пока GUI не заберет события
+    QMutex m_spaceMutex;
+    QWaitCondition m_spaceFreed;
+    std::atomic<bool> m_writerWaiting;
+};
+
+#endif // RUNWORKER_H
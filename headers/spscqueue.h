@@ -0,0 +1,76 @@
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// Кольцевая очередь без блокировок для одного писателя и одного читателя.
+// Писатель меняет только m_tail, читатель - только m_head, поэтому
+// достаточно пары атомарных счетчиков с acquire/release.
+// Емкость округляется вверх до степени двойки.
+template<typename T>
+class SpscQueue
+{
+public:
+    explicit SpscQueue(size_t capacity = 1 << 14)
+        : m_buffer(roundUp(capacity))
+        , m_mask(m_buffer.size() - 1)
+        , m_head(0)
+        , m_tail(0)
+    {
+    }
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // Только из потока-писателя; false - очередь заполнена
+    bool tryPush(T&& value)
+    {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) == m_buffer.size()) {
+            return false;
+        }
+        m_buffer[tail & m_mask] = std::move(value);
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Только из потока-читателя; false - очередь пуста
+    bool tryPop(T& value)
+    {
+        size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        value = std::move(m_buffer[head & m_mask]);
+        // Освобождаем ячейку сразу, а не при следующей записи в нее
+        m_buffer[head & m_mask] = T();
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool isEmpty() const
+    {
+        return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+    }
+
+    size_t capacity() const { return m_buffer.size(); }
+
+private:
+    static size_t roundUp(size_t value)
+    {
+        size_t capacity = 2;
+        while (capacity < value) capacity <<= 1;
+        return capacity;
+    }
+
+    std::vector<T> m_buffer;
+    const size_t m_mask;
+    // Счетчики на разных кэш-линиях, чтобы потоки не мешали друг другу
+    alignas(64) std::atomic<size_t> m_head;
+    alignas(64) std::atomic<size_t> m_tail;
+};
+
+#endif // SPSCQUEUE_H
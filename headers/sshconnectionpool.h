@@ -0,0 +1,74 @@
+#ifndef SSHCONNECTIONPOOL_H
+#define SSHCONNECTIONPOOL_H
+
+#include <QObject>
+#include <QProcess>
+#include <QHash>
+#include <QTimer>
+#include <QElapsedTimer>
+#include "common.h"
+
+// Постоянные мастер-подключения SSH (ControlMaster) к хостам.
+// Мастер поднимается один раз и переживает запуски: ansible-playbook и
+// прямой SSH-движок подключаются через его сокет без повторной авторизации.
+// Раз в интервал состояние мастеров проверяется (ssh -O check),
+// неиспользуемые дольше заданного времени закрываются.
+// Пул один на приложение (его держит RunQueue): у каждого сокета ControlPath
+// ровно один мастер, исполнители только просят поднять его через warmUp.
+class SshConnectionPool : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum class State {
+        Cold,
+        Connecting,
+        Warm,
+        Failed
+    };
+
+    explicit SshConnectionPool(QObject *parent = nullptr);
+    ~SshConnectionPool();
+
+    void setIdleTimeout(int seconds);
+    // Поднимает мастер-подключения для хостов, у которых их еще нет
+    void warmUp(const QList<HostConfig>& hosts);
+    // Отмечает использование подключения (сбрасывает таймер простоя)
+    // Хосты идентифицируются по HostConfig::endpoint()
+    void touch(const QString& endpoint);
+    State state(const QString& endpoint) const;
+    void closeAll();
+
+    static QString controlPath(const HostConfig& host);
+    // Опции ssh для работы через общий мастер
+    static QStringList controlOptions();
+    static QString stateText(State state);
+
+signals:
+    void hostStateChanged(const QString& endpoint, SshConnectionPool::State state);
+
+private slots:
+    void onHealthTimer();
+    void onCheckFinished(int exitCode, QProcess::ExitStatus status);
+
+private:
+    struct Master {
+        HostConfig host;
+        QProcess *process = nullptr;
+        // Номер группы процессов мастера в WSL (processtree.h)
+        QString pidFile;
+        State state = State::Cold;
+        QElapsedTimer lastUsed;
+    };
+
+    void startMaster(Master& master);
+    void closeMaster(Master& master);
+    void setState(Master& master, State state);
+
+    QHash<QString, Master> m_masters;
+    QTimer *m_healthTimer;
+    QProcess *m_checkProcess;
+    int m_idleTimeoutSec;
+};
+
+#endif // SSHCONNECTIONPOOL_H
@@ -0,0 +1,158 @@
+#ifndef SSHEXECUTOR_H
+#define SSHEXECUTOR_H
+
+#include <QObject>
+#include <QProcess>
+#include <QList>
+#include <QStringList>
+#include <QFile>
+#include <QElapsedTimer>
+#include <QTimer>
+#include "common.h"
+#include "artifactcache.h"
+#include "lineframer.h"
+
+// Собственный движок выполнения: те же шаги, что и в ansible.yml
+// (копирование скрипта, копирование архива, распаковка и запуск),
+// но напрямую через ssh, без запуска ansible-playbook. Скрипт и архив
+// передаются через кэш на хосте (artifactcache.h) - повторно не отправляются.
+// Все хосты обрабатываются параллельно, процессы управляются
+// событийным циклом Qt (без блокирующих ожиданий).
+class SshExecutor : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit SshExecutor(QObject *parent = nullptr);
+    ~SshExecutor();
+
+    void setHosts(const QList<HostConfig>& hosts);
+    void setScriptPath(const QString& path);
+    void setArchivePath(const QString& path);
+    // Каталог запуска для патчей дельта-передачи
+    void setStagingDir(const QString& dir);
+    void setMaxParallel(int count);
+    // Слитный режим: скрипт встраивается в сценарий, одно SSH-обращение на хост
+    void setFusedMode(bool enabled);
+    // Потоковая передача архива: архив читается порциями и подается в ssh,
+    // на хосте сразу распаковывается tar из stdin (без копии архива на диске)
+    void setStreamArchive(bool enabled);
+    // Раздача архива деревом (fanouttree.h): degree сидов, 0 - выключено
+    void setFanoutDegree(int degree);
+    // Пределы времени в секундах (0 - без предела): одного шага и всего хоста.
+    // Дерево процессов зависшего хоста останавливается, остальные хосты
+    // продолжают, не дожидаясь его
+    void setTimeouts(int stepTimeoutSec, int hostTimeoutSec);
+    int maxParallel() const { return m_maxParallel; }
+
+    void start();
+    void stop();
+    bool isRunning() const { return m_isRunning; }
+
+    // Количество шагов на один хост (зависит от наличия архива)
+    int stepsPerHost() const;
+
+    static QString shellQuote(const QString& value);
+
+signals:
+    void outputReceived(const QString& text);
+    void hostStepStarted(const QString& host, const QString& stepName);
+    void hostStepFinished(const QString& host, const QString& stepName, bool success);
+    // unreachable - ssh не смог подключиться к хосту: код 255 до первого
+    // служебного маркера удаленной команды
+    void hostFinished(const QString& host, bool success, bool unreachable);
+    // Хост остановлен по пределу времени на шаге stepName (до hostFinished)
+    void hostTimedOut(const QString& host, const QString& stepName);
+    void progressUpdated(int completedSteps, int totalSteps, const QString& stepName);
+    // Передача артефакта на хост: sent - отправлено байт, saved - взято из кэша хоста
+    void artifactTransferred(const QString& host, qint64 sent, qint64 saved);
+    void finished(bool success);
+
+private slots:
+    void onHostProcessFinished(int exitCode, QProcess::ExitStatus status);
+    void onHostProcessErrorOccurred(QProcess::ProcessError error);
+    void onHostProcessOutput();
+    void checkTimeouts();
+
+private:
+    enum Step {
+        CopyScript,
+        CopyArchive,
+        Execute,
+        Done
+    };
+
+    struct HostJob {
+        HostConfig host;
+        Step step = CopyScript;
+        QProcess *process = nullptr;
+        bool failed = false;
+        bool unreachable = false;
+        bool timedOut = false;
+        bool finished = false;
+        QFile *source = nullptr;
+        qint64 bytesSent = 0;
+        bool cacheHit = false;
+        bool usedDelta = false;
+        // Удаленная команда шага запустилась (пришел @@CAS или @@STEP):
+        // код 255 после этого - код скрипта, а не ошибка подключения ssh
+        bool remoteStarted = false;
+        // Маркер кэша принимается один раз за шаг копирования
+        bool markerSeen = false;
+        // Раздача деревом: индекс родителя в m_jobs (-1 - управляющая машина)
+        int parent = -1;
+        bool relay = false;
+        bool relayFailed = false;
+        bool archiveReady = false;
+        QElapsedTimer stepTimer;
+        // С первого шага хоста; предел хоста считается от него
+        QElapsedTimer hostTimer;
+        // Номер группы процессов шага в WSL (processtree.h)
+        QString pidFile;
+        // Вывод шага нарезается на строки по мере поступления, незавершенная
+        // строка ждет следующего чтения
+        LineFramer output{4096};
+    };
+
+    void scheduleJobs();
+    void startStep(HostJob& job);
+    void finishStep(HostJob& job, bool success);
+    Step firstStep() const;
+    Step nextStep(Step step) const;
+    QString stepName(Step step) const;
+    QStringList buildStepArguments(const HostJob& job) const;
+    QStringList sshOptions(const HostConfig& host) const;
+    QString buildRemoteCommand(const HostConfig& host) const;
+    bool isStreaming() const;
+    bool isWaitingForParent(const HostJob& job) const;
+    void handleCacheMarker(HostJob& job, ArtifactCache::Marker marker);
+    void handleOutputLine(HostJob& job, const QByteArray& line);
+    void feedSource(HostJob& job);
+    void closeSource(HostJob& job);
+    // Отвязывает процесс шага от хоста и останавливает его дерево в фоне
+    void abandonProcess(HostJob& job);
+    HostJob* findJob(QProcess *process);
+    void checkAllFinished();
+
+    QList<HostJob> m_jobs;
+    QList<HostConfig> m_hosts;
+    QString m_scriptPath;
+    QString m_archivePath;
+    QString m_stagingDir;
+    QByteArray m_scriptContent;
+    ArtifactCache::Artifact m_scriptArtifact;
+    ArtifactCache::Artifact m_archiveArtifact;
+    ArtifactCache::Delta m_archiveDelta;
+    int m_maxParallel;
+    int m_activeCount;
+    int m_completedSteps;
+    bool m_isRunning;
+    bool m_fusedMode;
+    bool m_streamArchive;
+    int m_fanoutDegree;
+    int m_stepTimeoutSec;
+    int m_hostTimeoutSec;
+    QTimer *m_watchdog;
+};
+
+#endif // SSHEXECUTOR_H
@@ -0,0 +1,75 @@
+#ifndef UPDATECOALESCER_H
+#define UPDATECOALESCER_H
+
+#include <QObject>
+#include <QHash>
+#include <QStringList>
+#include <QTimer>
+#include "progressmanager.h"
+
+// Объединение обновлений интерфейса во время запуска.
+// Строки журнала копятся пачкой, а прогресс, строка состояния и проценты
+// хостов хранятся только последними значениями. Всё это применяется к
+// виджетам не чаще одного раза за кадр (интервал таймера), поэтому
+// разговорчивый запуск не перестраивает окно на каждую строку.
+// Начало и конец прогресса - барьеры: накопленное сбрасывается сразу.
+class UpdateCoalescer : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Stats {
+        int flushes = 0;       // сколько раз обновлялись виджеты
+        qint64 lines = 0;      // выведено строк журнала
+        qint64 merged = 0;     // обновлений прогресса, перекрытых более новыми
+        qint64 dropped = 0;    // строк, отброшенных при переполнении пачки
+    };
+
+    explicit UpdateCoalescer(QObject *parent = nullptr);
+
+    void setProgressManager(ProgressManager *manager);
+    // Интервал сброса, мс (по умолчанию - кадр 60 Гц)
+    void setInterval(int msec);
+
+    void appendLine(const QString& text);
+    void setProgress(int value);
+    void setStatusText(const QString& text);
+    void setHostProgress(const QString& endpoint, int percent);
+    void setHostEta(const QString& endpoint, qint64 remainingMs, bool slow);
+    void setEta(qint64 remainingMs);
+    void startProgress();
+    void stopProgress(bool success);
+
+    // Применить накопленное немедленно
+    void flush();
+
+    Stats stats() const { return m_stats; }
+    void resetStats();
+    QString summary() const;
+
+signals:
+    // Пачка строк журнала в порядке поступления
+    void linesReady(const QStringList& lines);
+
+private:
+    void schedule();
+
+    ProgressManager *m_progressManager;
+    QTimer m_timer;
+
+    QStringList m_lines;
+    qint64 m_droppedSinceFlush;
+
+    bool m_hasProgress;
+    int m_progress;
+    bool m_hasStatus;
+    QString m_status;
+    QHash<QString, int> m_hostProgress;
+    QHash<QString, QPair<qint64, bool>> m_hostEta;
+    bool m_hasEta;
+    qint64 m_eta;
+
+    Stats m_stats;
+};
+
+#endif // UPDATECOALESCER_H
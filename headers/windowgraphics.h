@@ -8,11 +8,14 @@
 #include <QLineEdit>
 #include <QPushButton>
 #include <QListWidget>
-#include <QTextEdit>
 #include <QGroupBox>
 #include <QStatusBar>
 #include <QProgressBar>
+#include <QComboBox>
+#include <QSpinBox>
+#include <QCheckBox>
 #include "progressmanager.h"
+#include "logview.h"
 class WindowGraphics : public QWidget
 {
     Q_OBJECT
@@ -29,16 +32,40 @@ public:
     QPushButton* getRemoveHostButton() const { return removeHostButton; }
     QPushButton* getPlayButton() const { return playButton; }
     QListWidget* getHostsListWidget() const { return hostsListWidget; }
-    QTextEdit* getOutputTextEdit() const { return outputTextEdit; }
+    LogView* getOutputView() const { return outputView; }
     QProgressBar* getProgressBar() const { return progressBar; } // Новый геттер
+    QComboBox* getEngineComboBox() const { return engineComboBox; }
+    QSpinBox* getBatchSizeSpinBox() const { return batchSizeSpinBox; }
+    QSpinBox* getConcurrencySpinBox() const { return concurrencySpinBox; }
+    QCheckBox* getFusedCheckBox() const { return fusedCheckBox; }
+    QCheckBox* getStreamArchiveCheckBox() const { return streamArchiveCheckBox; }
+    QCheckBox* getLiveOutputCheckBox() const { return liveOutputCheckBox; }
+    QSpinBox* getFanoutSpinBox() const { return fanoutSpinBox; }
+    QSpinBox* getPreflightSpinBox() const { return preflightSpinBox; }
+    QSpinBox* getMaxRunsSpinBox() const { return maxRunsSpinBox; }
+    QListWidget* getRunQueueListWidget() const { return runQueueListWidget; }
+    QPushButton* getCancelRunButton() const { return cancelRunButton; }
+    QPushButton* getRetryFailedButton() const { return retryFailedButton; }
+    QSpinBox* getRetriesSpinBox() const { return retriesSpinBox; }
+    QSpinBox* getCanarySpinBox() const { return canarySpinBox; }
+    QSpinBox* getMaxFailSpinBox() const { return maxFailSpinBox; }
+    QSpinBox* getTaskTimeoutSpinBox() const { return taskTimeoutSpinBox; }
+    QSpinBox* getHostTimeoutSpinBox() const { return hostTimeoutSpinBox; }
 
     // Методы обновления интерфейса
     void updateFilePathLabel(const QString& text, bool success);
     void appendOutput(const QString& text);
+    // Пачка строк - одна перерисовка окна журнала
+    void appendOutputLines(const QStringList& lines);
+    void appendHostOutput(const QString& host, const QString& task, const QString& text);
     void appendStatusBar(const QString& text);
     void clearOutput();
     void addHostToList(const QString& hostInfo);
     void removeHostFromList(int row);
+    void setHostStatus(int row, const QString& status);
+    // Строка запуска в списке очереди (номер запуска хранится в UserRole)
+    void setRunQueueItem(int jobId, const QString& text);
+    void removeRunQueueItem(int jobId);
     ProgressManager* getProgressManager() const { return progressManager; }
 // protected:
 //     void dragEnterEvent(QDragEnterEvent *event) override;
@@ -56,9 +83,28 @@ private:
     QPushButton *removeHostButton;
     QPushButton *playButton;
     QListWidget *hostsListWidget;
-    QTextEdit *outputTextEdit;
+    LogView *outputView;
+    QComboBox *hostLogComboBox;
+    QComboBox *taskLogComboBox;
     QStatusBar *statusBar;
     QProgressBar *progressBar; // Новый элемент
+    QComboBox *engineComboBox;
+    QSpinBox *batchSizeSpinBox;
+    QSpinBox *concurrencySpinBox;
+    QCheckBox *fusedCheckBox;
+    QCheckBox *streamArchiveCheckBox;
+    QCheckBox *liveOutputCheckBox;
+    QSpinBox *fanoutSpinBox;
+    QSpinBox *preflightSpinBox;
+    QSpinBox *maxRunsSpinBox;
+    QListWidget *runQueueListWidget;
+    QPushButton *cancelRunButton;
+    QPushButton *retryFailedButton;
+    QSpinBox *retriesSpinBox;
+    QSpinBox *canarySpinBox;
+    QSpinBox *maxFailSpinBox;
+    QSpinBox *taskTimeoutSpinBox;
+    QSpinBox *hostTimeoutSpinBox;
     ProgressManager *progressManager;
 };
 
@@ -0,0 +1,137 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+Выполнение команды с построчной трансляцией вывода в CpuStatCheck.
+
+Запускается на управляющей машине задачей playbook (delegate_to: localhost):
+  python3 live_exec.py --host web1 --task "Execute script" -- ssh ... bash script
+
+Каждая строка stdout/stderr команды сразу отправляется в канал из переменной
+CPUSTAT_LIVE_FIFO (его создает callback_plugins/cpustat_events.py), и раннер
+показывает ее в журнале, пока команда еще работает. Без переменной скрипт
+просто выполняет команду.
+
+По завершении печатает хвост stdout/stderr (для register) и выходит с кодом
+команды. Память ограничена: хранится не больше MAX_TAIL байт каждого потока,
+а запись в канал блокируется, если раннер не успевает читать, - это
+притормаживает и удаленный скрипт через ssh.
+"""
+
+import argparse
+import collections
+import json
+import os
+import selectors
+import subprocess
+import sys
+
+# Запись в канал до PIPE_BUF байт атомарна - строки разных хостов не перемешиваются
+MAX_RECORD = 3500
+MAX_LINE = 2000
+MAX_TAIL = 1024 * 1024
+
+
+class Tail:
+    def __init__(self):
+        self.lines = collections.deque()
+        self.size = 0
+        self.dropped = 0
+
+    def add(self, line):
+        self.lines.append(line)
+        self.size += len(line)
+        while self.size > MAX_TAIL and len(self.lines) > 1:
+            self.size -= len(self.lines.popleft())
+            self.dropped += 1
+
+    def dump(self, stream):
+        if self.dropped:
+            stream.write("... (пропущено строк: %d)\n" % self.dropped)
+        for line in self.lines:
+            stream.write(line + "\n")
+        stream.flush()
+
+
+def open_channel():
+    path = os.environ.get("CPUSTAT_LIVE_FIFO")
+    if not path:
+        return None
+    try:
+        return os.open(path, os.O_WRONLY)
+    except OSError:
+        return None
+
+
+def send(channel, host, task, stream, line):
+    if channel is None:
+        return channel
+    record = json.dumps({"host": host, "task": task, "stream": stream, "line": line[:MAX_LINE]},
+                        ensure_ascii=False, separators=(",", ":")).encode("utf-8")
+    if len(record) >= MAX_RECORD:
+        record = json.dumps({"host": host, "task": task, "stream": stream, "line": line[:MAX_LINE // 4]},
+                            ensure_ascii=True, separators=(",", ":")).encode("utf-8")
+    try:
+        os.write(channel, record + b"\n")
+    except OSError:
+        # Читатель пропал - дальше команда выполняется без трансляции
+        os.close(channel)
+        return None
+    return channel
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--host", required=True)
+    parser.add_argument("--task", default="")
+    parser.add_argument("command", nargs=argparse.REMAINDER)
+    args = parser.parse_args()
+    command = args.command[1:] if args.command[:1] == ["--"] else args.command
+    if not command:
+        parser.error("command is required")
+
+    channel = open_channel()
+    process = subprocess.Popen(command, stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+
+    tails = {"out": Tail(), "err": Tail()}
+    pending = {"out": b"", "err": b""}
+    selector = selectors.DefaultSelector()
+    selector.register(process.stdout, selectors.EVENT_READ, "out")
+    selector.register(process.stderr, selectors.EVENT_READ, "err")
+
+    def emit(stream, raw):
+        line = raw.decode("utf-8", "replace").rstrip("\r")
+        tails[stream].add(line)
+        return send(channel, args.host, args.task, stream, line)
+
+    open_streams = 2
+    while open_streams:
+        for key, _ in selector.select():
+            stream = key.data
+            chunk = os.read(key.fileobj.fileno(), 65536)
+            if not chunk:
+                selector.unregister(key.fileobj)
+                open_streams -= 1
+                if pending[stream]:
+                    channel = emit(stream, pending[stream])
+                    pending[stream] = b""
+                continue
+            data = pending[stream] + chunk
+            lines = data.split(b"\n")
+            pending[stream] = lines.pop()
+            # Строка без перевода строки не копится бесконечно
+            if len(pending[stream]) > 65536:
+                lines.append(pending[stream])
+                pending[stream] = b""
+            for raw in lines:
+                channel = emit(stream, raw)
+
+    rc = process.wait()
+    if channel is not None:
+        os.close(channel)
+    tails["out"].dump(sys.stdout)
+    tails["err"].dump(sys.stderr)
+    return rc
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,177 @@
+#include "ansiblecontroller.h"
+#include "processtree.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QDebug>
+
+AnsibleController::AnsibleController(QObject *parent)
+    : QObject(parent)
+    , m_process(new QProcess(this))
+    , m_nextJobId(1)
+    , m_ready(false)
+{
+    connect(m_process, &QProcess::readyReadStandardOutput, this, &AnsibleController::onProcessOutput);
+    connect(m_process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+            this, &AnsibleController::onProcessFinished);
+    connect(m_process, &QProcess::errorOccurred, this, &AnsibleController::onProcessErrorOccurred);
+}
+
+AnsibleController::~AnsibleController()
+{
+    shutdown();
+}
+
+void AnsibleController::setWorkerScriptPath(const QString& wslPath)
+{
+    m_workerScriptPath = wslPath;
+}
+
+void AnsibleController::ensureStarted()
+{
+    if (isStarted()) return;
+
+    m_ready = false;
+    m_framer.clear();
+
+    // Контроллеров может быть несколько (по одному на рабочий поток очереди)
+    m_pidFile = QDir::temp().filePath(QString("cpustat-controller-%1-%2.pid")
+                                      .arg(QCoreApplication::applicationPid())
+                                      .arg(quintptr(this), 0, 16));
+    QStringList command;
+    command << "python3" << "-u" << m_workerScriptPath;
+    qDebug() << "Запуск контроллера Ansible:" << command;
+    m_process->start("wsl", ProcessTree::wrap(m_pidFile, command));
+}
+
+int AnsibleController::submitJob(const QStringList& playbookArgs)
+{
+    int jobId = m_nextJobId++;
+
+    QJsonObject request;
+    request["id"] = jobId;
+    request["args"] = QJsonArray::fromStringList(playbookArgs);
+
+    m_activeJobs.insert(jobId);
+    ensureStarted();
+
+    QByteArray line = QJsonDocument(request).toJson(QJsonDocument::Compact) + "\n";
+    if (m_ready) {
+        writeRequest(line);
+    } else {
+        // Контроллер еще загружает Ansible - отправим после @@READY
+        m_pendingRequests.insert(jobId, line);
+    }
+
+    return jobId;
+}
+
+void AnsibleController::cancelJob(int jobId)
+{
+    if (!m_activeJobs.contains(jobId)) return;
+
+    if (m_pendingRequests.remove(jobId) > 0) {
+        // Задание еще не отправлено: отмена пришла бы в контроллер раньше него
+        // и была бы проигнорирована. Снимаем здесь, итог - в следующем цикле событий
+        m_activeJobs.remove(jobId);
+        QMetaObject::invokeMethod(this, [this, jobId]() {
+            emit jobFinished(jobId, CancelledExitCode);
+        }, Qt::QueuedConnection);
+        return;
+    }
+
+    QJsonObject request;
+    request["cancel"] = jobId;
+    writeRequest(QJsonDocument(request).toJson(QJsonDocument::Compact) + "\n");
+}
+
+void AnsibleController::shutdown()
+{
+    if (!isStarted()) return;
+
+    // Закрытие stdin - сигнал контроллеру снять задания и выйти. Не ждем:
+    // контроллер и задания (у каждого своя группа) останавливаются в фоне
+    m_process->closeWriteChannel();
+    ProcessTree::terminate(m_process, m_pidFile);
+}
+
+void AnsibleController::writeRequest(const QByteArray& request)
+{
+    if (m_process->state() == QProcess::Running) {
+        m_process->write(request);
+    }
+}
+
+void AnsibleController::onProcessOutput()
+{
+    m_framer.readFrom(m_process, [this](const QByteArray& line) {
+        handleLine(line);
+    });
+}
+
+void AnsibleController::handleLine(const QByteArray& line)
+{
+    if (line.startsWith("@@OUT ")) {
+        int space = line.indexOf(' ', 6);
+        int jobId = line.mid(6, space < 0 ? -1 : space - 6).toInt();
+        emit jobOutput(jobId, space < 0 ? QByteArray() : line.mid(space + 1));
+    } else if (line.startsWith("@@EVT ")) {
+        int space = line.indexOf(' ', 6);
+        if (space > 0) {
+            emit jobEvent(line.mid(6, space - 6).toInt(), line.mid(space + 1));
+        }
+    } else if (line.startsWith("@@DONE ")) {
+        QList<QByteArray> parts = line.split(' ');
+        if (parts.size() >= 3) {
+            int jobId = parts[1].toInt();
+            m_activeJobs.remove(jobId);
+            emit jobFinished(jobId, parts[2].toInt());
+        }
+    } else if (line.startsWith("@@READY")) {
+        m_ready = true;
+        m_ansibleVersion = QString::fromUtf8(line.mid(8)).trimmed();
+        for (const QByteArray& request : m_pendingRequests) {
+            writeRequest(request);
+        }
+        m_pendingRequests.clear();
+        emit ready(m_ansibleVersion);
+    } else if (line.startsWith("@@ERROR")) {
+        emit controllerError(QString::fromUtf8(line.mid(8)).trimmed());
+    } else if (!line.isEmpty()) {
+        qDebug() << "Контроллер Ansible:" << line;
+    }
+}
+
+void AnsibleController::failActiveJobs()
+{
+    m_pendingRequests.clear();
+    const QSet<int> jobs = m_activeJobs;
+    m_activeJobs.clear();
+    for (int jobId : jobs) {
+        emit jobFinished(jobId, -1);
+    }
+}
+
+void AnsibleController::onProcessFinished(int exitCode, QProcess::ExitStatus status)
+{
+    qDebug() << "Контроллер Ansible завершился, код:" << exitCode << status;
+    ProcessTree::release(m_pidFile);
+
+    bool wasReady = m_ready;
+    m_ready = false;
+    if (!wasReady) {
+        emit controllerError(QString("Контроллер Ansible не запустился (код %1)").arg(exitCode));
+    }
+    failActiveJobs();
+}
+
+void AnsibleController::onProcessErrorOccurred(QProcess::ProcessError error)
+{
+    if (error != QProcess::FailedToStart) return;
+
+    m_ready = false;
+    emit controllerError("Не удалось запустить контроллер Ansible через WSL");
+    failActiveJobs();
+}
@@ -0,0 +1,89 @@
+#include "ansibleevent.h"
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+const char *AnsibleEvent::fdVariable = "CPUSTAT_EVENTS_FD";
+
+namespace {
+AnsibleEvent::Type typeFromName(const QString& name)
+{
+    if (name == "ok") return AnsibleEvent::Type::HostOk;
+    if (name == "host_start") return AnsibleEvent::Type::HostStart;
+    if (name == "task_start") return AnsibleEvent::Type::TaskStart;
+    if (name == "failed") return AnsibleEvent::Type::HostFailed;
+    if (name == "skipped") return AnsibleEvent::Type::HostSkipped;
+    if (name == "unreachable") return AnsibleEvent::Type::HostUnreachable;
+    if (name == "stats") return AnsibleEvent::Type::HostStats;
+    if (name == "live") return AnsibleEvent::Type::HostLive;
+    if (name == "play_start") return AnsibleEvent::Type::PlayStart;
+    if (name == "playbook_end") return AnsibleEvent::Type::PlaybookEnd;
+    return AnsibleEvent::Type::Unknown;
+}
+}
+
+bool AnsibleEvent::isHostResult() const
+{
+    return type == Type::HostOk || type == Type::HostFailed
+        || type == Type::HostUnreachable || type == Type::HostSkipped;
+}
+
+bool AnsibleEvent::parse(const QByteArray& line, AnsibleEvent& event)
+{
+    // Быстрая отсечка: события всегда начинаются с {"
+    if (line.size() < 2 || line.at(0) != '{' || line.at(1) != '"') {
+        return false;
+    }
+
+    QJsonParseError error;
+    QJsonDocument document = QJsonDocument::fromJson(line, &error);
+    if (error.error != QJsonParseError::NoError || !document.isObject()) {
+        return false;
+    }
+
+    QJsonObject object = document.object();
+    event = AnsibleEvent();
+    event.type = typeFromName(object.value("event").toString());
+    if (event.type == Type::Unknown) {
+        return false;
+    }
+
+    event.host = object.value("host").toString();
+    event.task = object.value("task").toString();
+
+    switch (event.type) {
+        case Type::PlayStart: {
+            event.task = object.value("play").toString();
+            event.taskCount = object.value("tasks").toInt();
+            const QJsonArray hosts = object.value("hosts").toArray();
+            for (const QJsonValue& host : hosts) {
+                event.hosts << host.toString();
+            }
+            break;
+        }
+        case Type::TaskStart:
+            event.taskIndex = object.value("index").toInt();
+            break;
+        case Type::HostStats:
+            event.okCount = object.value("ok").toInt();
+            event.changedCount = object.value("changed").toInt();
+            event.failedCount = object.value("failed").toInt();
+            event.unreachableCount = object.value("unreachable").toInt();
+            event.skippedCount = object.value("skipped").toInt();
+            break;
+        case Type::HostLive:
+            event.message = object.value("line").toString();
+            event.isStderr = object.value("stream").toString() == "err";
+            break;
+        default:
+            if (event.isHostResult()) {
+                event.changed = object.value("changed").toBool();
+                event.ignored = object.value("ignored").toBool();
+                event.timedOut = object.value("timedout").toBool();
+                event.durationMs = qint64(object.value("duration_ms").toDouble());
+                event.message = object.value("msg").toString();
+            }
+            break;
+    }
+    return true;
+}
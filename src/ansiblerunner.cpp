@@ -1,37 +1,98 @@
 #include "ansiblerunner.h"
+#include "remotebundle.h"
+#include "artifactcache.h"
+#include "deltatransfer.h"
+#include "fanouttree.h"
+#include "processtree.h"
+#include "reachabilityprober.h"
 #include <QCoreApplication>
 #include <QFile>
 #include <QTextStream>
 #include <QDir>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
 #include <QDebug>
 #include <QRegularExpression>
+#include <QThread>
+#include <QTimer>
+
+const char *AnsibleRunner::preflightTask = "Проверка доступности";
 
 AnsibleRunner::AnsibleRunner(QObject *parent)
     : QObject(parent)
-    , ansibleProcess(nullptr)
     , m_progressManager(nullptr)
-    , m_currentTaskIndex(0)
+    , m_engine(Engine::AnsiblePlaybook)
+    , m_sshExecutor(new SshExecutor(this))
+    , m_controller(new AnsibleController(this))
+    , m_useController(true)
+    , m_controllerUnavailable(false)
+    , m_shardCount(0)
+    , m_stopping(false)
+    , m_tuner(new ConcurrencyTuner(this))
+    , m_batchSize(0)
+    , m_forks(0)
+    , m_recordedConcurrency(5)
+    , m_fusedMode(false)
+    , m_streamArchive(false)
+    , m_liveOutput(false)
+    , m_fanoutDegree(0)
+    , m_maxFailPercent(100)
+    , m_taskTimeoutSec(0)
+    , m_hostTimeoutSec(0)
+    , m_preflightTimeoutMs(0)
+    , m_prober(new ReachabilityProber(this))
+    , m_connectionPool(nullptr)
+    , m_etaTimer(new QTimer(this))
+    , m_firstOutputSeen(false)
+    , m_coldStartLatencyMs(-1)
+    , m_cacheBytesSent(0)
+    , m_cacheBytesSaved(0)
 {
-    ansibleProcess = new QProcess(this);
+    connect(m_sshExecutor, &SshExecutor::outputReceived, this, &AnsibleRunner::onNativeOutput);
+    connect(m_sshExecutor, &SshExecutor::hostStepStarted, this, [this](const QString& host, const QString& stepName) {
+        m_nativeSteps.insert(host, stepName);
+        m_touchedHosts.insert(host);
+        emit taskStarted(stepName + " (" + host + ")");
+    });
+    connect(m_sshExecutor, &SshExecutor::hostStepStarted, m_tuner, &ConcurrencyTuner::taskStarted);
+    connect(m_sshExecutor, &SshExecutor::hostStepFinished, this, [this](const QString& host, const QString& stepName, bool success) {
+        m_tuner->taskFinished(host);
+        if (!success) {
+            m_nativeSteps.insert(host, stepName);
+        }
+    });
+    connect(m_sshExecutor, &SshExecutor::hostFinished, this, [this](const QString& host, bool success, bool unreachable) {
+        recordHostResult(host, success ? HostOutcome::Ok : unreachable ? HostOutcome::Unreachable : HostOutcome::Failed,
+                         success ? QString() : m_nativeSteps.value(host));
+    });
+    connect(m_sshExecutor, &SshExecutor::hostTimedOut, this, [this](const QString& host, const QString& stepName) {
+        // Итог "ошибка" из hostFinished его не перезапишет
+        recordHostResult(host, HostOutcome::TimedOut, stepName);
+    });
+    connect(m_prober, &ReachabilityProber::hostProbed, this, &AnsibleRunner::hostReachability);
+    connect(m_prober, &ReachabilityProber::finished, this, &AnsibleRunner::onPreflightFinished);
+    connect(m_sshExecutor, &SshExecutor::progressUpdated, this, &AnsibleRunner::onNativeProgress);
+    connect(m_sshExecutor, &SshExecutor::finished, this, &AnsibleRunner::onNativeFinished);
+    connect(m_sshExecutor, &SshExecutor::artifactTransferred, this, [this](const QString&, qint64 sent, qint64 saved) {
+        m_cacheBytesSent += sent;
+        m_cacheBytesSaved += saved;
+    });
 
-    connect(ansibleProcess, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
-            this, &AnsibleRunner::onProcessFinished);
-    connect(ansibleProcess, &QProcess::errorOccurred, this, &AnsibleRunner::onProcessErrorOccurred);
-    connect(ansibleProcess, &QProcess::readyReadStandardOutput, this, &AnsibleRunner::readProcessOutput);
-    connect(ansibleProcess, &QProcess::readyReadStandardError, this, &AnsibleRunner::readProcessOutput);
+    m_etaTimer->setInterval(1000);
+    connect(m_etaTimer, &QTimer::timeout, this, &AnsibleRunner::refreshEta);
 
-    inventoryPath = QCoreApplication::applicationDirPath() + "/inventory.ini";
-    qDebug() << inventoryPath;
-    
-    // Предопределенные задачи Ansible
-    m_taskNames = QStringList() 
-            << "Сбор информации о хостах"
-            << "Подготовка окружения"
-            << "Копирование скрипта на сервер"
-            << "Установка прав на выполнение"
-            << "Выполнение скрипта"
-            << "Сбор результатов"
-            << "Завершение";
+    connect(m_controller, &AnsibleController::jobOutput, this, &AnsibleRunner::onControllerJobOutput);
+    connect(m_controller, &AnsibleController::jobEvent, this, &AnsibleRunner::onControllerJobEvent);
+    connect(m_controller, &AnsibleController::jobFinished, this, &AnsibleRunner::onControllerJobFinished);
+    connect(m_controller, &AnsibleController::controllerError, this, &AnsibleRunner::onControllerError);
+    connect(m_tuner, &ConcurrencyTuner::concurrencyChanged, this, &AnsibleRunner::onConcurrencyChanged);
+    connect(m_controller, &AnsibleController::ready, this, [this](const QString& version) {
+        qDebug() << "Контроллер Ansible готов, версия:" << version;
+    });
+
+    // Без очереди запусков (runqueue.h) файлы запуска лежат рядом с программой
+    setStagingDir(QCoreApplication::applicationDirPath());
 }
 
 AnsibleRunner::~AnsibleRunner()
@@ -46,15 +107,54 @@ void AnsibleRunner::setProgressManager(ProgressManager* manager)
 
 void AnsibleRunner::stop()
 {
-    if (ansibleProcess && ansibleProcess->state() == QProcess::Running) {
-        ansibleProcess->terminate();
-        ansibleProcess->waitForFinished(3000);
+    // Добитый по таймауту wsl.exe завершает шард аварийно - это не повод перезапуска
+    m_stopping = true;
+    for (ShardRun& shard : m_shards) {
+        if (shard.process && shard.process->state() == QProcess::Running) {
+            // Не ждем завершения: останавливается все дерево в WSL (ansible-playbook,
+            // его рабочие процессы и ssh), итог придет через finished
+            ProcessTree::terminate(shard.process, shard.pidFile);
+        }
+        if (shard.jobId >= 0) {
+            // Контроллер сам доводит SIGTERM до SIGKILL (ansible_worker.py)
+            m_controller->cancelJob(shard.jobId);
+        }
+    }
+    // Остановка во время проверки доступности: запуск еще не начинался
+    if (m_prober->isRunning()) {
+        m_prober->abort();
+        finishRun(false, -1);
+        return;
+    }
+    // Прямое SSH-выполнение при остановке само не сообщает о завершении
+    bool nativeRunning = m_sshExecutor->isRunning();
+    m_sshExecutor->stop();
+    if (nativeRunning) {
+        finishRun(false, -1);
     }
 }
 
 void AnsibleRunner::setPlaybookPath(const QString& path)
 {
     playbookPath = path;
+    // План задач разбирается один раз и обновляется только при изменении файла
+    m_progressModel.load(path);
+
+    // ansible_worker.py лежит рядом с ansible.yml
+    QString workerPath = QFileInfo(path).absolutePath() + "/ansible_worker.py";
+    m_controller->setWorkerScriptPath(toWslPath(workerPath));
+}
+
+void AnsibleRunner::setStagingDir(const QString& dir)
+{
+    m_stagingDir = dir;
+    QDir().mkpath(dir);
+    m_sshExecutor->setStagingDir(dir);
+}
+
+QString AnsibleRunner::stagingPath(const QString& name) const
+{
+    return QDir(m_stagingDir).absoluteFilePath(name);
 }
 
 void AnsibleRunner::setScriptPath(const QString& path)
@@ -62,23 +162,195 @@ void AnsibleRunner::setScriptPath(const QString& path)
     scriptPath = path;
 }
 
+void AnsibleRunner::setArchivePath(const QString& path)
+{
+    archivePath = path;
+}
+
+void AnsibleRunner::setEngine(Engine engine)
+{
+    m_engine = engine;
+}
+
+void AnsibleRunner::setUseWarmController(bool enabled)
+{
+    m_useController = enabled;
+}
+
+void AnsibleRunner::warmUpController()
+{
+    if (m_useController && !m_controllerUnavailable) {
+        m_controller->ensureStarted();
+    }
+}
+
+void AnsibleRunner::setConnectionPool(SshConnectionPool *pool)
+{
+    m_connectionPool = pool;
+}
+
+void AnsibleRunner::warmUpConnections()
+{
+    if (!m_connectionPool) return;
+
+    // Пул принадлежит потоку очереди - вызов передается в его цикл событий
+    SshConnectionPool *pool = m_connectionPool;
+    const QList<HostConfig> hosts = m_runHosts;
+    QMetaObject::invokeMethod(pool, [pool, hosts]() {
+        pool->warmUp(hosts);
+    }, Qt::QueuedConnection);
+}
+
+void AnsibleRunner::setShardCount(int count)
+{
+    m_shardCount = qMax(0, count);
+}
+
+int AnsibleRunner::effectiveShardCount() const
+{
+    int count = m_shardCount > 0 ? m_shardCount : QThread::idealThreadCount();
+    return qBound(1, count, qMax(1, m_runHosts.size()));
+}
+
+void AnsibleRunner::setBatchSize(int size)
+{
+    m_batchSize = qMax(0, size);
+}
+
+void AnsibleRunner::setForks(int forks)
+{
+    m_forks = qMax(0, forks);
+}
+
+void AnsibleRunner::setRecordedConcurrency(int concurrency)
+{
+    if (concurrency > 0) {
+        m_recordedConcurrency = concurrency;
+    }
+}
+
+void AnsibleRunner::setFusedMode(bool enabled)
+{
+    m_fusedMode = enabled;
+    m_sshExecutor->setFusedMode(enabled);
+}
+
+void AnsibleRunner::setOutputPatterns(const QStringList& patterns)
+{
+    m_outputPatterns = patterns;
+}
+
+void AnsibleRunner::setLiveOutput(bool enabled)
+{
+    m_liveOutput = enabled;
+}
+
+void AnsibleRunner::setStreamArchive(bool enabled)
+{
+    m_streamArchive = enabled;
+    m_sshExecutor->setStreamArchive(enabled);
+}
+
+void AnsibleRunner::setMaxFailPercent(int percent)
+{
+    m_maxFailPercent = qBound(0, percent, 100);
+}
+
+void AnsibleRunner::setTimeouts(int taskTimeoutSec, int hostTimeoutSec)
+{
+    m_taskTimeoutSec = qMax(0, taskTimeoutSec);
+    m_hostTimeoutSec = qMax(0, hostTimeoutSec);
+}
+
+void AnsibleRunner::setFanoutDegree(int degree)
+{
+    m_fanoutDegree = qMax(0, degree);
+    m_sshExecutor->setFanoutDegree(m_fanoutDegree);
+}
+
+bool AnsibleRunner::writeBundleFile(const QString& path)
+{
+    QFile scriptFile(scriptPath);
+    if (!scriptFile.open(QIODevice::ReadOnly)) {
+        emit errorOccurred("Не удалось прочитать скрипт для слитного режима");
+        return false;
+    }
+
+    RemoteBundle bundle;
+    bundle.setScriptContent(scriptFile.readAll());
+    bundle.setArchiveName(archivePath.isEmpty() ? QString() : QFileInfo(archivePath).fileName());
+    bundle.setArchiveStreamed(m_streamArchive && RemoteBundle::canStream(archivePath));
+
+    QFile bundleFile(path);
+    if (!bundleFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        emit errorOccurred("Не удалось создать файл сценария для слитного режима");
+        return false;
+    }
+    bundleFile.write(bundle.build().toUtf8());
+    bundleFile.close();
+    return true;
+}
+
+int AnsibleRunner::effectiveForks() const
+{
+    return m_forks > 0 ? m_forks : m_recordedConcurrency;
+}
+
+int AnsibleRunner::effectiveTaskTimeout() const
+{
+    // Без отдельного предела задача не дольше всего хоста
+    return m_taskTimeoutSec > 0 ? m_taskTimeoutSec : m_hostTimeoutSec;
+}
+
+void AnsibleRunner::onConcurrencyChanged(int concurrency)
+{
+    if (m_engine == Engine::NativeSsh && m_sshExecutor->isRunning()) {
+        m_sshExecutor->setMaxParallel(concurrency);
+        emit outputReceived(QString("⚙️ Параллельность изменена: %1").arg(concurrency));
+    }
+}
+
 void AnsibleRunner::setHosts(const QList<HostConfig>& hosts)
 {
     hostsConfig = hosts;
+    m_runHosts = hosts;
+}
+
+void AnsibleRunner::setPreflightTimeout(int ms)
+{
+    m_preflightTimeoutMs = qMax(0, ms);
+}
+
+QString AnsibleRunner::inventoryName(const HostConfig& host, const QList<HostConfig>& hosts) const
+{
+    // Несколько sshd на одном адресе (например, на loopback) различаем по порту
+    for (const HostConfig& other : hosts) {
+        if (other.address == host.address && other.sshPort != host.sshPort) {
+            return QString("%1_%2").arg(host.address).arg(host.sshPort);
+        }
+    }
+    return host.address;
 }
 
-void AnsibleRunner::createInventoryFile()
+bool AnsibleRunner::createInventoryFile(const QString& path, const QList<HostConfig>& hosts)
 {
-    QFile file(inventoryPath);
+    QFile file(path);
 
     if (file.open(QIODevice::WriteOnly | QIODevice::Text)) {
         QTextStream stream(&file);
         stream << "[webservers]\n";
 
-        for (int i = 0; i < hostsConfig.size(); ++i) {
-            const HostConfig &host = hostsConfig[i];
+        // Раздача архива деревом: порядок хостов в inventory задает ярусы
+        FanoutTree tree(archivePath.isEmpty() ? 0 : hosts.size(), m_fanoutDegree);
 
-            stream << host.address;
+        for (int i = 0; i < hosts.size(); ++i) {
+            const HostConfig &host = hosts[i];
+            const QString name = m_inventoryNames.value(host.endpoint(), host.address);
+
+            stream << name;
+            if (name != host.address) {
+                stream << " ansible_host=" << host.address;
+            }
             stream << " ansible_user=" << host.sshUser;
 
             if (!host.sshPass.isEmpty()) {
@@ -87,155 +359,487 @@ void AnsibleRunner::createInventoryFile()
             }
 
             stream << " ansible_connection=ssh";
-            stream << " ansible_port=22";
-            stream << " ansible_ssh_extra_args='-o PubkeyAuthentication=no -o PasswordAuthentication=yes'";
+            stream << " ansible_port=" << host.sshPort;
+            // При раздаче деревом родитель подключается к потомку ключом из
+            // проброшенного агента: пароли хостов на другие хосты не передаются
+            stream << " ansible_ssh_extra_args='-o PubkeyAuthentication=no -o PasswordAuthentication=yes"
+                   << (tree.isEnabled() ? " -o ForwardAgent=yes'" : "'");
+            if (tree.isEnabled()) {
+                stream << " relay_tier=" << tree.tier(i);
+                if (tree.parent(i) >= 0) {
+                    const HostConfig &parent = hosts[tree.parent(i)];
+                    stream << " relay_parent=" << m_inventoryNames.value(parent.endpoint(), parent.address);
+                }
+            }
             stream << "\n";
         }
 
         stream << "\n[webservers:vars]\n";
-        stream << "ansible_ssh_common_args='-o StrictHostKeyChecking=no -o PubkeyAuthentication=no -o PasswordAuthentication=yes'\n";
+        stream << "ansible_ssh_common_args='-o StrictHostKeyChecking=no -o PubkeyAuthentication=no -o PasswordAuthentication=yes "
+               << SshConnectionPool::controlOptions().join(" ") << "'\n";
+        stream << "ansible_pipelining=true\n";
+        if (tree.isEnabled()) {
+            stream << "relay_depth=" << tree.depth() << "\n";
+        }
 
-        if (!hostsConfig.isEmpty() && !hostsConfig[0].sshPass.isEmpty()) {
-            stream << "ansible_become_pass=" << hostsConfig[0].sshPass << "\n";
-            stream << "ansible_sudo_pass=" << hostsConfig[0].sshPass << "\n";
+        if (!hosts.isEmpty() && !hosts[0].sshPass.isEmpty()) {
+            stream << "ansible_become_pass=" << hosts[0].sshPass << "\n";
+            stream << "ansible_sudo_pass=" << hosts[0].sshPass << "\n";
         }
 
         file.close();
-        emit outputReceived("📄 Inventory файл создан");
-    } else {
-        emit errorOccurred("Не удалось создать inventory файл");
+        return true;
     }
+
+    emit errorOccurred("Не удалось создать inventory файл");
+    return false;
 }
 
-bool AnsibleRunner::updateScriptPathInPlaybook(const QString& playbookPath, const QString& scriptPath)
+void AnsibleRunner::executePlaybook()
 {
-    if (scriptPath.isEmpty()) return false;
-
-    QFile playbookFile(playbookPath);
-    qDebug() << playbookPath;
-    if (!playbookFile.exists()) {
-        emit errorOccurred("Файл ansible.yml не найден в папке проекта!");
-        return false;
-    }
+    m_shards.clear();
+    m_hostResults.clear();
+    m_touchedHosts.clear();
+    m_runHosts = hostsConfig;
+    m_stopping = false;
 
-    if (!playbookFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        emit errorOccurred("Не удалось прочитать файл ansible.yml");
-        return false;
+    if (m_preflightTimeoutMs > 0 && !hostsConfig.isEmpty()) {
+        // Развертывание продолжится в onPreflightFinished
+        emit outputReceived(QString("📡 Проверка доступности хостов: %1, срок подключения %2 мс")
+                            .arg(hostsConfig.size()).arg(m_preflightTimeoutMs));
+        m_preflightTimer.start();
+        m_prober->setTimeout(m_preflightTimeoutMs);
+        m_prober->start(hostsConfig);
+        return;
     }
 
-    QString content = QString::fromUtf8(playbookFile.readAll());
-    playbookFile.close();
+    startDeployment();
+}
 
-    QString wslScriptPath = convertToWslPath(scriptPath);
-    qDebug() << wslScriptPath;
-    QStringList lines = content.split("\n");
-    for (int i = 0; i < lines.size(); ++i) {
-        if (lines[i].contains("script_src:")) {
-            lines[i] = QString("    script_src: \"%1\"").arg(wslScriptPath);
-            break;
+void AnsibleRunner::onPreflightFinished()
+{
+    // Недоступные хосты не попадают ни в inventory, ни в прямое выполнение;
+    // их итог "недоступен" - очередь повторит их позже вместе с упавшими
+    const QHash<QString, ReachabilityProber::Result>& results = m_prober->results();
+    m_runHosts.clear();
+    QStringList dead;
+    for (const HostConfig& host : hostsConfig) {
+        const ReachabilityProber::Result result = results.value(host.endpoint());
+        if (result.reachable) {
+            m_runHosts.append(host);
+        } else {
+            dead << QString("%1 (%2)").arg(host.endpoint(), result.error);
+            recordHostResult(host.endpoint(), HostOutcome::Unreachable, preflightTask);
         }
     }
 
-    if (playbookFile.open(QIODevice::WriteOnly | QIODevice::Text | QIODevice::Truncate)) {
-        playbookFile.write(lines.join("\n").toUtf8());
-        playbookFile.close();
-        return true;
+    emit outputReceived(QString("📡 Доступно хостов: %1 из %2 за %3 мс")
+                        .arg(m_runHosts.size()).arg(hostsConfig.size()).arg(m_preflightTimer.elapsed()));
+    if (!dead.isEmpty()) {
+        emit outputReceived(QString("🔌 Отложены недоступные хосты (%1): %2").arg(dead.size()).arg(dead.join(", ")));
     }
 
-    return false;
+    if (m_runHosts.isEmpty()) {
+        emit errorOccurred("Ни один хост не ответил на SSH-порту");
+        finishRun(false, -1);
+        return;
+    }
+
+    startDeployment();
 }
 
-void AnsibleRunner::executePlaybook()
+void AnsibleRunner::startDeployment()
 {
-    createInventoryFile();
+    if (m_engine == Engine::NativeSsh) {
+        executeNative();
+    } else {
+        executeAnsible();
+    }
+}
 
+void AnsibleRunner::executeAnsible()
+{
     emit outputReceived("🚀 Запуск Ansible playbook...");
     emit outputReceived("📋 Используется playbook: " + playbookPath);
 
-    // Сброс индекса задачи
-    m_currentTaskIndex = 0;
-    
+    // Делим хосты на шарды по кругу, у каждого шарда свой inventory
+    int shardCount = effectiveShardCount();
+    m_shards.clear();
+    for (int i = 0; i < shardCount; ++i) {
+        ShardRun shard;
+        shard.index = i;
+        shard.inventoryPath = shardCount == 1
+            ? stagingPath("inventory.ini")
+            : stagingPath(QString("inventory_shard_%1.ini").arg(i + 1));
+        m_shards.append(shard);
+    }
+    for (int i = 0; i < m_runHosts.size(); ++i) {
+        m_shards[i % shardCount].hosts.append(m_runHosts[i]);
+    }
+
+    // В слитном режиме используется отдельный короткий playbook (ansible_fused.yml).
+    // Пути артефактов передаются через -e: playbook не меняется, и запуски
+    // из очереди с разными скриптами не мешают друг другу. Переменные пишутся
+    // JSON-файлом в каталог подготовки (-e @файл): в пути %TEMP% может быть
+    // пробел из имени пользователя, а key=value ansible делит по пробелам
+    QString runPlaybookPath = playbookPath;
+    QJsonObject extraVars;
+    if (m_fusedMode) {
+        QString bundlePath = stagingPath("cpustat_bundle.sh");
+        if (!writeBundleFile(bundlePath)) {
+            finishRun(false, -1);
+            return;
+        }
+        runPlaybookPath = QFileInfo(playbookPath).absolutePath() + "/ansible_fused.yml";
+        extraVars["bundle_src"] = toWslPath(bundlePath);
+        emit outputReceived("🧩 Слитный режим: один сценарий на хост");
+    } else {
+        extraVars["script_src"] = toWslPath(scriptPath);
+    }
+    extraVars["archive_src"] = archivePath.isEmpty() ? QString() : toWslPath(archivePath);
+    // Хеши артефактов для кэша на хостах: передаются только отсутствующие там blob
+    ArtifactCache::Artifact scriptArtifact = ArtifactCache::describe(scriptPath);
+    if (scriptArtifact.isValid()) {
+        extraVars["script_sha"] = scriptArtifact.sha256;
+        extraVars["script_size"] = scriptArtifact.size;
+    }
+    if (!archivePath.isEmpty()) {
+        ArtifactCache::Artifact archiveArtifact = ArtifactCache::describe(archivePath);
+        if (archiveArtifact.isValid()) {
+            extraVars["archive_sha"] = archiveArtifact.sha256;
+            extraVars["archive_size"] = archiveArtifact.size;
+
+            // Хостам с прошлой версией архива передается только патч
+            QString summary;
+            ArtifactCache::Delta delta = DeltaTransfer::prepare(archiveArtifact, m_stagingDir, &summary);
+            if (!summary.isEmpty()) {
+                emit outputReceived(summary);
+            }
+            if (delta.isValid()) {
+                extraVars["archive_base_sha"] = delta.baseSha;
+                extraVars["archive_patch"] = toWslPath(delta.patchPath);
+                extraVars["archive_patch_size"] = delta.patchSize;
+            }
+        }
+    }
+    if (m_streamArchive && !archivePath.isEmpty()) {
+        if (RemoteBundle::canStream(archivePath)) {
+            extraVars["stream_archive"] = true;
+            emit outputReceived("📦 Потоковая передача архива с распаковкой на хосте");
+        } else {
+            emit outputReceived("⚠️ Потоковая передача поддерживается только для tar/tar.gz, архив будет скопирован");
+        }
+    }
+
+    if (m_maxFailPercent < 100) {
+        // Ansible не запускает следующие партии, если в текущей упало больше порога
+        extraVars["max_fail_pct"] = m_maxFailPercent;
+    }
+
+    // Предел времени задачи на хосте: зависшая задача завершается с ошибкой
+    // только на этом хосте
+    int taskTimeout = effectiveTaskTimeout();
+    if (taskTimeout > 0) {
+        extraVars["task_timeout"] = taskTimeout;
+        emit outputReceived(QString("⏱ Предел времени задачи на хосте: %1 с").arg(taskTimeout));
+    }
+
+    if (m_liveOutput) {
+        // live_exec.py лежит рядом с ansible.yml
+        QString helperPath = QFileInfo(playbookPath).absolutePath() + "/live_exec.py";
+        extraVars["live_helper"] = toWslPath(helperPath);
+        emit outputReceived("📡 Вывод скрипта транслируется в реальном времени");
+    }
+
+    if (m_batchSize > 0) {
+        extraVars["deploy_batch_size"] = m_batchSize;
+    }
+
+    QString varsPath = stagingPath("extra_vars.json");
+    QFile varsFile(varsPath);
+    if (!varsFile.open(QIODevice::WriteOnly) || varsFile.write(QJsonDocument(extraVars).toJson()) < 0) {
+        emit errorOccurred("Не удалось создать файл переменных запуска");
+        finishRun(false, -1);
+        return;
+    }
+    varsFile.close();
+
+    // Параллельность делится между шардами
+    int forksPerShard = qMax(1, (effectiveForks() + shardCount - 1) / shardCount);
+
+    // Имена считаются по всем хостам запуска, а не по шарду: два sshd на одном
+    // адресе в разных шардах иначе получили бы одно имя
+    m_inventoryNames.clear();
+    m_inventoryEndpoints.clear();
+    for (const HostConfig& host : m_runHosts) {
+        QString name = inventoryName(host, m_runHosts);
+        m_inventoryNames.insert(host.endpoint(), name);
+        m_inventoryEndpoints.insert(name, host.endpoint());
+    }
+
+    for (ShardRun& shard : m_shards) {
+        if (!createInventoryFile(shard.inventoryPath, shard.hosts)) {
+            finishRun(false, -1);
+            return;
+        }
+        shard.arguments << "-i" << toWslPath(shard.inventoryPath);
+        shard.arguments << "-f" << QString::number(forksPerShard);
+        shard.arguments << "-e" << "@" + toWslPath(varsPath);
+        shard.arguments << toWslPath(runPlaybookPath);
+        // shard.arguments << "-v"; // Для более детального вывода
+    }
+    emit outputReceived(QString("📄 Inventory файлы созданы (шардов: %1)").arg(shardCount));
+
+    // Классификатор строк вывода собирается один раз на запуск
+    m_outputMatcher = OutputMatcher::forAnsible(m_outputPatterns);
+    m_userPatternHits.fill(0, m_outputMatcher.userPatternCount());
+
+    // Модель прогресса: хосты (как их называет inventory) x задачи playbook
+    QStringList inventoryHosts;
+    for (const ShardRun& shard : m_shards) {
+        for (const HostConfig& host : shard.hosts) {
+            inventoryHosts << m_inventoryNames.value(host.endpoint());
+        }
+    }
+    if (m_progressModel.load(runPlaybookPath)) {
+        emit outputReceived(QString("📊 Задач в playbook: %1").arg(m_progressModel.tasks().size()));
+    }
+    m_progressModel.reset(inventoryHosts);
+    m_sentEta.clear();
+    m_slowWarned.clear();
+    m_etaTimer->start();
+
     // Запуск менеджера прогресса
     if (m_progressManager) {
-        m_progressManager->startProgress(m_taskNames.size());
+        m_progressManager->startProgress(100);
         m_progressManager->setStatusText("Подготовка к запуску...");
     }
 
-    QStringList arguments;
-    arguments << "-i" << convertToWslPath(inventoryPath);
-    arguments << convertToWslPath(playbookPath);
-    // arguments << "-v"; // Для более детального вывода
-
     emit outputReceived("\n⚡ Выполнение playbook...");
-    emit outputReceived("Команда: ansible-playbook " + arguments.join(" "));
+    emit outputReceived("Команда: ansible-playbook " + m_shards.first().arguments.join(" "));
+
+    m_runTimer.start();
+    m_firstOutputSeen = false;
+    m_cacheBytesSent = 0;
+    m_cacheBytesSaved = 0;
+    if (m_forks == 0) {
+        m_tuner->start(effectiveForks());
+    }
+
+    if (m_useController && !m_controllerUnavailable && !m_controller->isReady()) {
+        emit outputReceived("🔥 Запуск контроллера Ansible (один раз за сессию)...");
+    }
 
-    QStringList wslArgs;
-    wslArgs << "--" << "ansible-playbook" << arguments;
-    ansibleProcess->start("wsl", wslArgs);
+    warmUpConnections();
+
+    for (ShardRun& shard : m_shards) {
+        startShard(shard);
+    }
 }
 
-bool AnsibleRunner::updateArchivePathInPlaybook(const QString& playbookPath, const QString& archivePath)
+void AnsibleRunner::startShard(ShardRun& shard)
 {
-    if (archivePath.isEmpty()) return false;
+    ++shard.attempts;
+    shard.taskIndex = -1;
 
-    QFile playbookFile(playbookPath);
-    qDebug() << "Updating archive path in:" << playbookPath;
-    
-    if (!playbookFile.exists()) {
-        emit errorOccurred("Файл ansible.yml не найден в папке проекта!");
-        return false;
+    if (m_useController && !m_controllerUnavailable) {
+        shard.jobId = m_controller->submitJob(shard.arguments);
+    } else {
+        startShardProcess(shard);
     }
+}
 
-    if (!playbookFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        emit errorOccurred("Не удалось прочитать файл ansible.yml");
-        return false;
+void AnsibleRunner::startShardProcess(ShardRun& shard)
+{
+    shard.jobId = -1;
+
+    if (shard.process) {
+        shard.process->deleteLater();
     }
+    shard.process = new QProcess(this);
+    shard.outFramer.clear();
+    shard.errFramer.clear();
 
-    QString content = QString::fromUtf8(playbookFile.readAll());
-    playbookFile.close();
+    connect(shard.process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+            this, &AnsibleRunner::onProcessFinished);
+    connect(shard.process, &QProcess::errorOccurred, this, &AnsibleRunner::onProcessErrorOccurred);
+    connect(shard.process, &QProcess::readyReadStandardOutput, this, &AnsibleRunner::readProcessOutput);
+    connect(shard.process, &QProcess::readyReadStandardError, this, &AnsibleRunner::readProcessOutput);
 
-    QString wslArchivePath = convertToWslPath(archivePath);
-    qDebug() << "WSL archive path:" << wslArchivePath;
-    
-    QStringList lines = content.split("\n");
-    bool found = false;
-    
-    for (int i = 0; i < lines.size(); ++i) {
-        if (lines[i].contains("archive_src:")) {
-            lines[i] = QString("    archive_src: \"%1\"").arg(wslArchivePath);
-            found = true;
-            qDebug() << "Found and updated archive_src at line" << i;
-            break;
+    // Плагин событий пишет NDJSON в stderr - через wsl передаются только
+    // стандартные потоки, а предупреждения Ansible отличаются от событий
+    QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+    env.insert(AnsibleEvent::fdVariable, "2");
+    QString wslEnv = env.value("WSLENV");
+    QString passVariable = QString("%1/u").arg(AnsibleEvent::fdVariable);
+    env.insert("WSLENV", wslEnv.isEmpty() ? passVariable : wslEnv + ":" + passVariable);
+    shard.process->setProcessEnvironment(env);
+
+    // Своя группа процессов в WSL: остановка снимает и ansible-playbook, и его потомков
+    shard.pidFile = stagingPath(QString("shard_%1.pid").arg(shard.index + 1));
+    shard.process->start("wsl", ProcessTree::wrap(shard.pidFile, QStringList() << "ansible-playbook" << shard.arguments));
+}
+
+AnsibleRunner::ShardRun* AnsibleRunner::findShardByProcess(QObject *process)
+{
+    for (ShardRun& shard : m_shards) {
+        if (shard.process && shard.process == process) {
+            return &shard;
         }
     }
-    
-    if (!found) {
-        qDebug() << "Warning: archive_src not found in playbook";
-        // Можно добавить новую строку после script_src
-        for (int i = 0; i < lines.size(); ++i) {
-            if (lines[i].contains("script_src:")) {
-                lines.insert(i + 1, QString("    archive_src: \"%1\"").arg(wslArchivePath));
-                found = true;
-                qDebug() << "Added archive_src after script_src";
-                break;
-            }
+    return nullptr;
+}
+
+AnsibleRunner::ShardRun* AnsibleRunner::findShardByJob(int jobId)
+{
+    for (ShardRun& shard : m_shards) {
+        if (shard.jobId >= 0 && shard.jobId == jobId) {
+            return &shard;
         }
     }
+    return nullptr;
+}
 
-    if (playbookFile.open(QIODevice::WriteOnly | QIODevice::Text | QIODevice::Truncate)) {
-        playbookFile.write(lines.join("\n").toUtf8());
-        playbookFile.close();
-        return found;
+void AnsibleRunner::handleShardExit(ShardRun& shard, int exitCode, bool crashed)
+{
+    shard.jobId = -1;
+
+    // 250 - внутренняя ошибка ansible-playbook, отрицательный код - процесс умер
+    bool died = crashed || exitCode < 0 || exitCode == 250;
+    if (died && !m_stopping && shard.attempts < 2) {
+        emit outputReceived(QString("⚠️ Шард %1 аварийно завершился, перезапуск (хостов: %2)")
+                            .arg(shard.index + 1).arg(shard.hosts.size()));
+        startShard(shard);
+        return;
     }
 
-    return false;
+    shard.finished = true;
+    shard.exitCode = died && exitCode == 0 ? 1 : exitCode;
+    if (shard.exitCode != 0) {
+        emit outputReceived(QString("❌ Шард %1 завершился с кодом %2").arg(shard.index + 1).arg(shard.exitCode));
+    }
+
+    int failedCode = 0;
+    for (const ShardRun& other : m_shards) {
+        if (!other.finished) return;
+        if (other.exitCode != 0 && failedCode == 0) {
+            failedCode = other.exitCode;
+        }
+    }
+
+    finishRun(failedCode == 0, failedCode);
+}
+
+void AnsibleRunner::reportStartupLatency()
+{
+    if (m_firstOutputSeen) return;
+    m_firstOutputSeen = true;
+
+    qint64 latency = m_runTimer.elapsed();
+    if (m_coldStartLatencyMs < 0) {
+        m_coldStartLatencyMs = latency;
+        emit outputReceived(QString("⏱ Задержка запуска (первый запуск): %1 мс").arg(latency));
+    } else {
+        emit outputReceived(QString("⏱ Задержка запуска (повторный запуск): %1 мс, первый запуск: %2 мс")
+                            .arg(latency).arg(m_coldStartLatencyMs));
+    }
+}
+
+void AnsibleRunner::onControllerJobOutput(int jobId, const QByteArray& line)
+{
+    ShardRun *shard = findShardByJob(jobId);
+    if (!shard) return;
+
+    reportStartupLatency();
+    handleOutputLine(line, false, *shard);
+}
+
+void AnsibleRunner::onControllerJobEvent(int jobId, const QByteArray& json)
+{
+    ShardRun *shard = findShardByJob(jobId);
+    if (!shard) return;
+
+    AnsibleEvent event;
+    if (AnsibleEvent::parse(json, event)) {
+        handleEvent(event, *shard);
+    }
+}
+
+void AnsibleRunner::onControllerJobFinished(int jobId, int exitCode)
+{
+    ShardRun *shard = findShardByJob(jobId);
+    if (!shard) return;
+
+    if (exitCode < 0 && m_controllerUnavailable && shard->taskIndex < 0 && !m_stopping) {
+        // Контроллер не поднялся - выполняем этот шард обычным способом
+        emit outputReceived("⚠️ Контроллер недоступен, запуск ansible-playbook напрямую");
+        startShardProcess(*shard);
+        return;
+    }
+
+    handleShardExit(*shard, exitCode, exitCode < 0);
+}
+
+void AnsibleRunner::onControllerError(const QString& message)
+{
+    qDebug() << "Ошибка контроллера Ansible:" << message;
+    if (!m_controller->isReady()) {
+        m_controllerUnavailable = true;
+    }
+}
+
+void AnsibleRunner::executeNative()
+{
+    emit outputReceived("🚀 Запуск прямого SSH-выполнения (без ansible-playbook)...");
+
+    if (m_progressManager) {
+        m_progressManager->startProgress(100);
+        m_progressManager->setStatusText("Подготовка к запуску...");
+    }
+
+    m_runTimer.start();
+    m_cacheBytesSent = 0;
+    m_cacheBytesSaved = 0;
+    m_nativeSteps.clear();
+    for (const HostConfig& host : m_runHosts) {
+        m_nativeSteps.insert(host.endpoint(), QString());
+    }
+    if (m_forks == 0) {
+        m_tuner->start(effectiveForks());
+        emit outputReceived(QString("⚙️ Автоподбор параллельности, начальное значение: %1").arg(effectiveForks()));
+    }
+    warmUpConnections();
+    m_sshExecutor->setMaxParallel(effectiveForks());
+    m_sshExecutor->setHosts(m_runHosts);
+    m_sshExecutor->setScriptPath(scriptPath);
+    m_sshExecutor->setArchivePath(archivePath);
+    m_sshExecutor->setTimeouts(m_taskTimeoutSec, m_hostTimeoutSec);
+    m_sshExecutor->start();
+}
+
+void AnsibleRunner::onNativeProgress(int completedSteps, int totalSteps, const QString& stepName)
+{
+    if (totalSteps <= 0) return;
+
+    int percent = qMin(100, completedSteps * 100 / totalSteps);
+    if (m_progressManager) {
+        m_progressManager->updateProgress(percent, stepName);
+        // Истории по шагам прямого выполнения нет - оценка по прошедшему времени
+        m_progressManager->setEta(-1);
+    }
+    emit progressUpdated(percent, stepName);
+}
+
+void AnsibleRunner::onNativeFinished(bool success)
+{
+    finishRun(success, success ? 0 : 1);
 }
 
-bool AnsibleRunner::convertScriptToUnixFormat(const QString& filePath, QString& convertedPath, QString* archivePath)
+bool AnsibleRunner::convertScriptToUnixFormat(const QString& filePath, const QString& convertedPath, QString* error)
 {
     QFile file(filePath);
     if (!file.open(QIODevice::ReadOnly)) {
-        emit errorOccurred("Не удалось открыть файл для конвертации");
+        if (error) *error = "Не удалось открыть файл для конвертации: " + filePath;
         return false;
     }
 
@@ -256,29 +860,34 @@ bool AnsibleRunner::convertScriptToUnixFormat(const QString& filePath, QString&
         content += '\n';
     }
 
-    QString tempFilePath = QDir::temp().absoluteFilePath("script_converted.sh");
-    
-    QFile tempFile(tempFilePath);
-    if (!tempFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        emit errorOccurred("Не удалось создать временный файл");
+    QFile convertedFile(convertedPath);
+    if (!convertedFile.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        if (error) *error = "Не удалось создать файл скрипта: " + convertedPath;
         return false;
     }
 
-    QTextStream out(&tempFile);
-    out.setCodec("UTF-8");
-    out << content;
-    tempFile.close();
+    QByteArray converted = content.toUtf8();
+    if (convertedFile.write(converted) != converted.size() || !convertedFile.flush()) {
+        if (error) *error = "Не удалось записать файл скрипта: " + convertedPath;
+        convertedFile.close();
+        QFile::remove(convertedPath);
+        return false;
+    }
+    convertedFile.close();
 
-    QStringList chmodArgs;
-    chmodArgs << "--" << "chmod" << "+x" << convertToWslPath(tempFilePath);
+    // Права на выполнение не нужны: скрипт на хостах запускается через bash
+    return true;
+}
 
-    QProcess chmod;
-    chmod.start("wsl", chmodArgs);
-    chmod.waitForFinished(3000);
+bool AnsibleRunner::stageScript(const QString& filePath, QString* archivePath)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        emit errorOccurred("Не удалось открыть файл скрипта");
+        return false;
+    }
+    file.close();
 
-    // Сохраняем путь к сконвертированному скрипту
-    convertedPath = tempFilePath;
-    
     // Если передан указатель на archivePath (не nullptr), ищем архив
     if (archivePath != nullptr) {
         QFileInfo fileInfo(filePath);
@@ -300,92 +909,325 @@ bool AnsibleRunner::convertScriptToUnixFormat(const QString& filePath, QString&
         }
     }
 
-    emit outputReceived("🔄 Скрипт сконвертирован в Unix-формат");
-
     return true;
 }
 
-QString AnsibleRunner::convertToWslPath(const QString& windowsPath) const
+void AnsibleRunner::handleOutputLine(const QByteArray& line, bool isError, ShardRun& shard)
 {
-    QString wslPath = windowsPath;
-    wslPath.replace('\\', '/');
+    // Сначала классифицируем байты за один проход, затем один раз декодируем
+    quint64 userMatches = 0;
+    quint32 kind = m_outputMatcher.classify(line.constData(), line.size(), &userMatches);
+    QString text = QString::fromUtf8(line.constData(), line.size());
 
-    if (wslPath.contains(':')) {
-        QString driveLetter = wslPath.left(1).toLower();
-        wslPath = wslPath.mid(2);
-        wslPath = QString("/mnt/%1%2").arg(driveLetter, wslPath);
+    QString formatted;
+    if (isError || (kind & (OutputMatcher::Fatal | OutputMatcher::Unreachable | OutputMatcher::Failed))) {
+        formatted = "<span style='color:red'>" + text.toHtmlEscaped() + "</span>";
+    } else if (kind & OutputMatcher::UserPattern) {
+        formatted = "<span style='background-color:#fff3b0'>" + text.toHtmlEscaped() + "</span>";
+    } else {
+        formatted = text;
     }
+    emit outputReceived(formatted);
 
-    return wslPath;
-}
+    if (!isError) {
+        attributeLine(line, kind, shard);
+        if (!shard.currentHost.isEmpty()) {
+            emit hostOutputReceived(m_inventoryEndpoints.value(shard.currentHost, shard.currentHost),
+                                    shard.currentTask, formatted);
+        }
+    }
+
+    if (kind & OutputMatcher::UserPattern) {
+        for (int i = 0; i < m_userPatternHits.size(); ++i) {
+            if (userMatches & (quint64(1) << i)) {
+                ++m_userPatternHits[i];
+            }
+        }
+    }
+
+    // Статистика кэша артефактов от playbook (по строке на хост)
+    if (kind & OutputMatcher::CasStats) {
+        static const QRegularExpression casRegex("@@CAS-STATS sent=(\\d+) saved=(\\d+)");
+        QRegularExpressionMatch match = casRegex.match(text);
+        if (match.hasMatch()) {
+            m_cacheBytesSent += match.captured(1).toLongLong();
+            m_cacheBytesSaved += match.captured(2).toLongLong();
+        }
+    }
 
-void AnsibleRunner::parseProgressFromOutput(const QString& output)
-{
     if (!m_progressManager) return;
 
-    // Анализируем вывод Ansible для определения текущей задачи
-    
-    // TASK [Gathering Facts]
-    if (output.contains("TASK [Gathering Facts]")) {
-        m_currentTaskIndex = 0;
-        emit taskStarted("Сбор информации о хостах");
-        m_progressManager->setStatusText("Сбор информации о хостах...");
-    }
-    // TASK [copy script]
-    else if (output.contains("TASK [copy script]") || output.contains("TASK [Копирование]")) {
-        m_currentTaskIndex = 2;
-        emit taskStarted("Копирование скрипта");
-        m_progressManager->setStatusText("Копирование скрипта на сервер...");
-    }
-    // TASK [make executable]
-    else if (output.contains("TASK [make executable]") || output.contains("chmod")) {
-        m_currentTaskIndex = 3;
-        emit taskStarted("Установка прав");
-        m_progressManager->setStatusText("Установка прав на выполнение...");
-    }
-    // TASK [execute script]
-    else if (output.contains("TASK [execute script]") || output.contains("TASK [Выполнение]")) {
-        m_currentTaskIndex = 4;
-        emit taskStarted("Выполнение скрипта");
-        m_progressManager->setStatusText("Выполнение скрипта на сервере...");
-    }
-    // PLAY RECAP
-    else if (output.contains("PLAY RECAP")) {
-        m_currentTaskIndex = 6;
-        emit taskStarted("Завершение");
+    // Строки статуса шагов слитного сценария
+    if (kind & OutputMatcher::BundleStep) {
+        RemoteBundle::StepStatus step;
+        if (RemoteBundle::parseStepLine(text, step) && step.finished) {
+            QString title = RemoteBundle::stepTitle(step.id);
+            emit taskCompleted(title);
+            m_progressManager->setStatusText(QString("%1: код %2, %3 мс")
+                                             .arg(title).arg(step.exitCode).arg(step.durationMs));
+        }
+    }
+    if (kind & OutputMatcher::PlayRecap) {
         m_progressManager->setStatusText("Завершение выполнения...");
     }
-    
-    // Обновляем прогресс на основе индекса задачи
-    if (m_currentTaskIndex < m_taskNames.size()) {
-        m_progressManager->updateProgress(m_currentTaskIndex + 1, m_taskNames[m_currentTaskIndex]);
+}
+
+void AnsibleRunner::attributeLine(const QByteArray& line, quint32 kind, ShardRun& shard)
+{
+    if (kind & OutputMatcher::TaskHeader) {
+        // TASK [роль : имя] *****
+        int open = line.indexOf('[');
+        int close = line.lastIndexOf(']');
+        shard.currentTask = close > open ? QString::fromUtf8(line.mid(open + 1, close - open - 1)) : QString();
+        shard.currentHost.clear();
+        return;
     }
-    
-    // Парсим прогресс по хостам
-    QRegularExpression hostProgressRegex("(\\w+)\\s*:\\s*ok=(\\d+)\\s*changed=(\\d+)\\s*unreachable=(\\d+)\\s*failed=(\\d+)");
-    QRegularExpressionMatch match = hostProgressRegex.match(output);
-    if (match.hasMatch()) {
-        QString host = match.captured(1);
-        int ok = match.captured(2).toInt();
-        int changed = match.captured(3).toInt();
-        int unreachable = match.captured(4).toInt();
-        int failed = match.captured(5).toInt();
-        
-        QString status = QString("Хост %1: OK=%2, Изменено=%3")
-            .arg(host).arg(ok).arg(changed);
-        
-        if (failed > 0) {
-            status += QString(", Ошибок=%1").arg(failed);
+    if (kind & OutputMatcher::PlayRecap) {
+        shard.inRecap = true;
+        shard.currentTask = "PLAY RECAP";
+        shard.currentHost.clear();
+        return;
+    }
+    if (line.isEmpty()) return;
+
+    if (shard.inRecap) {
+        // имя   : ok=3    changed=1 ...
+        int colon = line.indexOf(" : ok=");
+        shard.currentHost = colon > 0 ? QString::fromUtf8(line.left(colon)).trimmed() : QString();
+        return;
+    }
+
+    // ok: [имя], changed: [имя -> делегат], fatal: [имя]: FAILED! ...
+    int open = line.indexOf(": [");
+    if (open > 0 && open < 24 && line.at(0) >= 'a' && line.at(0) <= 'z') {
+        int close = line.indexOf(']', open + 3);
+        if (close > open) {
+            QByteArray name = line.mid(open + 3, close - open - 3);
+            int arrow = name.indexOf(" -> ");
+            if (arrow >= 0) name.truncate(arrow);
+            shard.currentHost = QString::fromUtf8(name);
+            return;
+        }
+    }
+
+    // Строки без отступа, не относящиеся к хосту (PLAY [...], предупреждения)
+    if (line.at(0) != ' ' && line.at(0) != '{' && line.at(0) != '}' && line.at(0) != '"') {
+        shard.currentHost.clear();
+    }
+}
+
+void AnsibleRunner::onNativeOutput(const QString& text)
+{
+    emit outputReceived(text);
+
+    // Строки прямого выполнения начинаются с "[адрес]", иногда после значка
+    int open = text.indexOf('[');
+    if (open < 0 || open > 4) return;
+    int close = text.indexOf(']', open + 1);
+    if (close < 0) return;
+
+    QString endpoint = text.mid(open + 1, close - open - 1);
+    if (m_nativeSteps.contains(endpoint)) {
+        emit hostOutputReceived(endpoint, m_nativeSteps.value(endpoint), text);
+    }
+}
+
+void AnsibleRunner::handleEvent(const AnsibleEvent& event, ShardRun& shard)
+{
+    switch (event.type) {
+        case AnsibleEvent::Type::TaskStart:
+            ++shard.taskIndex;
+            emit taskStarted(event.task);
+            if (m_progressManager) {
+                m_progressManager->setStatusText(event.task + "...");
+            }
+            break;
+
+        case AnsibleEvent::Type::HostStart:
+            if (m_forks == 0) {
+                m_tuner->taskStarted(event.host);
+            }
+            m_progressModel.hostTaskStarted(event.host, event.task);
+            m_touchedHosts.insert(m_inventoryEndpoints.value(event.host, event.host));
+            break;
+
+        case AnsibleEvent::Type::HostOk:
+        case AnsibleEvent::Type::HostSkipped:
+        case AnsibleEvent::Type::HostFailed:
+        case AnsibleEvent::Type::HostUnreachable: {
+            if (m_forks == 0) {
+                m_tuner->taskFinished(event.host);
+            }
+            m_progressModel.hostResult(event.host, event.task, event.durationMs);
+
+            bool hostLost = (event.type == AnsibleEvent::Type::HostFailed && !event.ignored)
+                            || event.type == AnsibleEvent::Type::HostUnreachable;
+            if (hostLost) {
+                // Задачу прервал предел времени (-e task_timeout): признак timedout
+                // в результате задачи, а у старых версий Ansible - ее длительность
+                int taskTimeout = effectiveTaskTimeout();
+                bool timedOut = event.type == AnsibleEvent::Type::HostFailed
+                                && (event.timedOut
+                                    || (taskTimeout > 0 && event.durationMs >= qint64(taskTimeout) * 1000));
+                recordHostResult(m_inventoryEndpoints.value(event.host, event.host),
+                                 event.type == AnsibleEvent::Type::HostUnreachable ? HostOutcome::Unreachable
+                                 : timedOut ? HostOutcome::TimedOut : HostOutcome::Failed,
+                                 event.task);
+                // Упавший хост выбывает из play - его прогресс закрываем
+                m_progressModel.hostFinished(event.host);
+                if (m_progressManager) {
+                    m_progressManager->setStatusText(QString("Хост %1: ошибка в задаче \"%2\"")
+                                                     .arg(event.host, event.task));
+                }
+            }
+            updateModelProgress(event.host, event.task);
+            break;
+        }
+
+        case AnsibleEvent::Type::HostStats:
+            recordHostResult(m_inventoryEndpoints.value(event.host, event.host),
+                             event.unreachableCount > 0 ? HostOutcome::Unreachable
+                             : event.failedCount > 0 ? HostOutcome::Failed : HostOutcome::Ok,
+                             QString());
+            m_progressModel.hostFinished(event.host);
+            updateModelProgress(event.host, QString());
+            if (m_progressManager) {
+                QString status = QString("Хост %1: OK=%2, Изменено=%3")
+                    .arg(event.host).arg(event.okCount).arg(event.changedCount);
+                if (event.failedCount > 0) {
+                    status += QString(", Ошибок=%1").arg(event.failedCount);
+                }
+                if (event.unreachableCount > 0) {
+                    status += QString(", Недоступен");
+                }
+                m_progressManager->setStatusText(status);
+            }
+            break;
+
+        case AnsibleEvent::Type::HostLive: {
+            QString endpoint = m_inventoryEndpoints.value(event.host, event.host);
+            QString text = QString("[%1] %2").arg(endpoint, event.message);
+            if (event.isStderr) {
+                text = "<span style='color:red'>" + text.toHtmlEscaped() + "</span>";
+            }
+            emit outputReceived(text);
+            emit hostOutputReceived(endpoint, event.task, text);
+            break;
+        }
+
+        case AnsibleEvent::Type::PlaybookEnd:
+            emit taskCompleted("Завершение");
+            break;
+
+        default:
+            break;
+    }
+}
+
+void AnsibleRunner::updateModelProgress(const QString& host, const QString& task)
+{
+    int percent = m_progressModel.percent();
+    if (m_progressManager) {
+        m_progressManager->updateProgress(percent);
+        m_progressManager->updateHostProgress(m_inventoryEndpoints.value(host, host),
+                                              m_progressModel.hostPercent(host));
+    }
+    emit progressUpdated(percent, task);
+}
+
+void AnsibleRunner::refreshEta()
+{
+    if (!m_progressManager) return;
+
+    const QStringList hosts = m_progressModel.hosts();
+    for (const QString& host : hosts) {
+        QString endpoint = m_inventoryEndpoints.value(host, host);
+        qint64 remaining = m_progressModel.hostRemainingMs(host);
+        QString slowTask = m_progressModel.slowTask(host);
+
+        // Отправляем только изменения с точностью до секунды
+        QPair<qint64, bool> state(remaining / 1000, !slowTask.isEmpty());
+        if (m_sentEta.value(host, qMakePair(qint64(-1), false)) != state) {
+            m_sentEta.insert(host, state);
+            m_progressManager->updateHostEta(endpoint, remaining, state.second);
+        }
+
+        if (!slowTask.isEmpty() && !m_slowWarned.contains(host + '\n' + slowTask)) {
+            m_slowWarned.insert(host + '\n' + slowTask);
+            emit outputReceived(QString("🐢 Хост %1: задача \"%2\" идет заметно дольше обычного (обычно ~%3)")
+                                .arg(endpoint, slowTask,
+                                     ProgressManager::formatDuration(m_progressModel.expectedMs(host, slowTask))));
         }
-        
-        m_progressManager->setStatusText(status);
     }
+    m_progressManager->setEta(m_progressModel.remainingMs());
 }
 
 void AnsibleRunner::onProcessFinished(int exitCode, QProcess::ExitStatus status)
 {
-    bool success = (exitCode == 0 && status == QProcess::NormalExit);
+    ShardRun *shard = findShardByProcess(sender());
+    if (!shard) return;
+
+    readShardOutput(*shard, true);
+    ProcessTree::release(shard->pidFile);
+    shard->process->deleteLater();
+    shard->process = nullptr;
+    handleShardExit(*shard, exitCode, status != QProcess::NormalExit);
+}
+
+void AnsibleRunner::finishRun(bool success, int exitCode)
+{
+    m_tuner->stop();
+    m_etaTimer->stop();
+    if (m_forks == 0) {
+        m_recordedConcurrency = m_tuner->recommendedConcurrency();
+        emit outputReceived(QString("⚙️ Параллельность для следующего запуска: %1").arg(m_recordedConcurrency));
+        emit tuningRecorded(m_recordedConcurrency, m_batchSize);
+    }
+
+    if (m_runTimer.isValid()) {
+        emit outputReceived(QString("⏱ Общее время выполнения: %1 мс").arg(m_runTimer.elapsed()));
+        m_runTimer.invalidate();
+    }
+
+    if (m_engine == Engine::AnsiblePlaybook) {
+        m_progressModel.saveDurations();
+    }
+
+    qint64 framedBytes = 0;
+    qint64 framedNsecs = 0;
+    for (const ShardRun& shard : m_shards) {
+        framedBytes += shard.outFramer.totalBytes() + shard.errFramer.totalBytes();
+        framedNsecs += shard.outFramer.busyNsecs() + shard.errFramer.busyNsecs();
+    }
+    if (m_engine == Engine::AnsiblePlaybook && framedBytes > 0 && framedNsecs > 0) {
+        emit outputReceived(QString("📈 Разбор вывода ansible-playbook: %1 за %2 мс (%3 МБ/с)")
+                            .arg(ArtifactCache::formatBytes(framedBytes))
+                            .arg(framedNsecs / 1000000.0, 0, 'f', 1)
+                            .arg((framedBytes / (1024.0 * 1024.0)) / (framedNsecs / 1e9), 0, 'f', 1));
+    }
+    if (m_engine == Engine::AnsiblePlaybook && m_outputMatcher.busyNsecs() > 0) {
+        // Автомат линеен по объему: МБ/с не должны падать на больших (-vvv) выводах
+        qint64 scanned = m_outputMatcher.scannedBytes();
+        qint64 nsecs = m_outputMatcher.busyNsecs();
+        emit outputReceived(QString("🔎 Классификация строк: %1 за %2 мс (%3 МБ/с)")
+                            .arg(ArtifactCache::formatBytes(scanned))
+                            .arg(nsecs / 1000000.0, 0, 'f', 1)
+                            .arg((scanned / (1024.0 * 1024.0)) / (nsecs / 1e9), 0, 'f', 1));
+        for (int i = 0; i < m_userPatternHits.size(); ++i) {
+            emit outputReceived(QString("🔎 Шаблон \"%1\": строк %2")
+                                .arg(QString::fromUtf8(m_outputMatcher.userPattern(i)))
+                                .arg(m_userPatternHits[i]));
+        }
+    }
+
+    if (m_cacheBytesSent > 0 || m_cacheBytesSaved > 0) {
+        emit outputReceived(QString("💾 Кэш артефактов: передано %1, сэкономлено %2")
+                            .arg(ArtifactCache::formatBytes(m_cacheBytesSent),
+                                 ArtifactCache::formatBytes(m_cacheBytesSaved)));
+    }
     
+    reportHostResults();
+
     if (m_progressManager) {
         m_progressManager->stopProgress(success);
 
@@ -403,8 +1245,74 @@ void AnsibleRunner::onProcessFinished(int exitCode, QProcess::ExitStatus status)
     emit finished(success, exitCode);
 }
 
+void AnsibleRunner::recordHostResult(const QString& endpoint, HostOutcome outcome, const QString& task)
+{
+    auto it = m_hostResults.find(endpoint);
+    if (it != m_hostResults.end() && it->first != HostOutcome::Ok) {
+        // Итоговая статистика приходит после ошибки - задачу ошибки сохраняем
+        return;
+    }
+    m_hostResults.insert(endpoint, qMakePair(outcome, task));
+}
+
+void AnsibleRunner::reportHostResults()
+{
+    int ok = 0;
+    int failed = 0;
+    int unreachable = 0;
+    int timedOut = 0;
+    int notStarted = 0;
+    QStringList details;
+    for (const HostConfig& host : hostsConfig) {
+        // Хост без итога считается упавшим, если на нем что-то начиналось
+        // (процесс прерван, остановка), иначе - не запускавшимся
+        QPair<HostOutcome, QString> result = m_hostResults.value(
+            host.endpoint(),
+            qMakePair(m_touchedHosts.contains(host.endpoint()) ? HostOutcome::Failed : HostOutcome::NotStarted,
+                      QString()));
+        switch (result.first) {
+            case HostOutcome::Ok:
+                ++ok;
+                break;
+            case HostOutcome::Failed:
+                ++failed;
+                details << QString("   ❌ %1: %2").arg(host.endpoint(),
+                                                      result.second.isEmpty() ? QString("нет итога") : "ошибка в \"" + result.second + "\"");
+                break;
+            case HostOutcome::Unreachable:
+                ++unreachable;
+                details << QString("   🔌 %1: недоступен").arg(host.endpoint());
+                break;
+            case HostOutcome::TimedOut:
+                ++timedOut;
+                details << QString("   ⏱ %1: превышено время в \"%2\"").arg(host.endpoint(), result.second);
+                break;
+            case HostOutcome::NotStarted:
+                ++notStarted;
+                details << QString("   ⏸ %1: не запускался").arg(host.endpoint());
+                break;
+        }
+        emit hostResult(host.endpoint(), result.first, result.second);
+    }
+
+    if (hostsConfig.isEmpty()) return;
+    QString summary = QString("📋 Итог по хостам: успешно %1, с ошибкой %2, недоступно %3")
+                      .arg(ok).arg(failed).arg(unreachable);
+    if (timedOut > 0) {
+        summary += QString(", по времени %1").arg(timedOut);
+    }
+    if (notStarted > 0) {
+        summary += QString(", не запускалось %1").arg(notStarted);
+    }
+    emit outputReceived(summary);
+    for (const QString& line : details) {
+        emit outputReceived(line);
+    }
+}
+
 void AnsibleRunner::onProcessErrorOccurred(QProcess::ProcessError error)
 {
+    ShardRun *shard = findShardByProcess(sender());
     QString errorMessage;
     switch (error) {
         case QProcess::FailedToStart:
@@ -426,25 +1334,59 @@ void AnsibleRunner::onProcessErrorOccurred(QProcess::ProcessError error)
             errorMessage = "Неизвестная ошибка.";
     }
 
-    if (m_progressManager) {
-        m_progressManager->stopProgress(false);
-        m_progressManager->setErrorMode(true); 
+    // Не запустившийся шард не получит finished() - обрабатываем его здесь
+    if (shard && error == QProcess::FailedToStart) {
+        shard->process->deleteLater();
+        shard->process = nullptr;
+        if (shard->attempts >= 2) {
+            emit errorOccurred(errorMessage);
+        }
+        handleShardExit(*shard, -1, true);
+        return;
     }
-    
-    emit errorOccurred(errorMessage);
+
+    emit outputReceived("<span style='color:red'>" + errorMessage + "</span>");
 }
 
 void AnsibleRunner::readProcessOutput()
 {
-    QString output = ansibleProcess->readAllStandardOutput();
-    QString error = ansibleProcess->readAllStandardError();
+    ShardRun *shard = findShardByProcess(sender());
+    if (!shard) return;
+
+    readShardOutput(*shard, false);
+}
+
+void AnsibleRunner::readShardOutput(ShardRun& shard, bool flush)
+{
+    QProcess *process = shard.process;
+    qint64 before = shard.outFramer.totalBytes() + shard.errFramer.totalBytes();
+
+    // Строка декодируется из UTF-8 один раз и дальше идет и в журнал, и в разбор
+    auto handleOutput = [this, &shard](const QByteArray& line) {
+        handleOutputLine(line, false, shard);
+    };
+    // В stderr плагин пишет события (callback_plugins/cpustat_events.py)
+    auto handleError = [this, &shard](const QByteArray& line) {
+        AnsibleEvent event;
+        if (AnsibleEvent::parse(line, event)) {
+            handleEvent(event, shard);
+            return;
+        }
+        handleOutputLine(line, true, shard);
+    };
+
+    process->setReadChannel(QProcess::StandardOutput);
+    shard.outFramer.readFrom(process, handleOutput);
+    process->setReadChannel(QProcess::StandardError);
+    shard.errFramer.readFrom(process, handleError);
+    process->setReadChannel(QProcess::StandardOutput);
 
-    if (!output.isEmpty()) {
-        emit outputReceived(output);
-        parseProgressFromOutput(output);
+    if (flush) {
+        shard.outFramer.flush(handleOutput);
+        shard.errFramer.flush(handleError);
     }
-    if (!error.isEmpty()) {
-        emit outputReceived("<span style='color:red'>" + error + "</span>");
-        parseProgressFromOutput(error);
+
+    if (shard.outFramer.totalBytes() + shard.errFramer.totalBytes() > before) {
+        reportStartupLatency();
     }
 }
\ No newline at end of file
@@ -0,0 +1,147 @@
+#include "artifactcache.h"
+#include "remotebundle.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRegularExpression>
+
+const char *ArtifactCache::remoteDir = "~/.cache/cpustat/blobs";
+const int ArtifactCache::retentionDays = 30;
+
+namespace {
+struct HashEntry {
+    qint64 size = -1;
+    QDateTime modified;
+    QString sha256;
+};
+
+// Общая часть команд: создать каталог кэша, удалить устаревшие blob и перейти в него
+QString prepareCache()
+{
+    return QString("mkdir -p %1 && find %1 -type f -mtime +%2 -delete; cd %1")
+        .arg(ArtifactCache::remoteDir)
+        .arg(ArtifactCache::retentionDays);
+}
+
+QString quoteArg(const QString& value)
+{
+    return "'" + QString(value).replace("'", "'\\''") + "'";
+}
+}
+
+ArtifactCache::Artifact ArtifactCache::describe(const QString& localPath)
+{
+    // Кэш общий для запусков из очереди, которые идут в разных потоках
+    static QHash<QString, HashEntry> hashCache;
+    static QMutex hashMutex;
+
+    Artifact artifact;
+    artifact.localPath = localPath;
+
+    QFileInfo info(localPath);
+    if (!info.exists() || !info.isFile()) {
+        return artifact;
+    }
+    artifact.size = info.size();
+
+    QMutexLocker locker(&hashMutex);
+    HashEntry& entry = hashCache[info.absoluteFilePath()];
+    if (entry.size == info.size() && entry.modified == info.lastModified()) {
+        artifact.sha256 = entry.sha256;
+        return artifact;
+    }
+
+    QFile file(localPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return artifact;
+    }
+
+    // addData(QIODevice*) читает файл порциями - архив целиком в память не попадает
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    if (!hash.addData(&file)) {
+        return artifact;
+    }
+
+    entry.size = info.size();
+    entry.modified = info.lastModified();
+    entry.sha256 = QString::fromLatin1(hash.result().toHex());
+    artifact.sha256 = entry.sha256;
+    return artifact;
+}
+
+QString ArtifactCache::blobPath(const Artifact& artifact)
+{
+    return QString("%1/%2").arg(remoteDir, artifact.sha256);
+}
+
+QString ArtifactCache::fetchCommand(const Artifact& artifact, const QString& dest, bool link,
+                                   const Delta& delta)
+{
+    const QString& sha = artifact.sha256;
+    QString install = link
+        ? QString("ln -sf %1 %2").arg(blobPath(artifact), quoteArg(dest))
+        : QString("cp %1 %2").arg(sha, quoteArg(dest));
+
+    return QString("%1 && if [ -f %2 ]; then touch %2 && echo @@CAS hit; %3"
+                   "else echo @@CAS need && head -c %4 > %2.part && %5; fi && %6")
+        .arg(prepareCache(), sha, deltaBranch(artifact, delta))
+        .arg(artifact.size)
+        .arg(verifyAndCommit(sha), install);
+}
+
+QString ArtifactCache::streamExtractCommand(const Artifact& artifact, const QString& archiveName,
+                                            const Delta& delta)
+{
+    const QString& sha = artifact.sha256;
+    QString dir = quoteArg(RemoteBundle::extractDirFor(archiveName));
+    QString flags = RemoteBundle::tarExtractFlags(archiveName);
+
+    // Патч нельзя распаковывать на лету - сначала собираем blob, затем распаковываем его
+    QString patched = deltaBranch(artifact, delta, QString(" && tar %1 %2 -C %3").arg(flags, sha, dir));
+
+    return QString("%1 && mkdir -p %2 && if [ -f %3 ]; then touch %3 && echo @@CAS hit && tar %4 %3 -C %2; %5"
+                   "else echo @@CAS need && head -c %6 | tee %3.part | tar %4 - -C %2 && %7; fi && %8")
+        .arg(prepareCache(), dir, sha, flags, patched)
+        .arg(artifact.size)
+        .arg(verifyAndCommit(sha), RemoteBundle::manifestCommand(archiveName));
+}
+
+QString ArtifactCache::deltaBranch(const Artifact& artifact, const Delta& delta, const QString& then)
+{
+    if (!delta.isValid()) {
+        return QString();
+    }
+    // Патч - сценарий bash, собирающий <sha>.part из базовой версии и вставок
+    return QString("elif [ -f %1 ]; then echo @@CAS delta && head -c %2 | bash && %3%4; ")
+        .arg(delta.baseSha)
+        .arg(delta.patchSize)
+        .arg(verifyAndCommit(artifact.sha256), then);
+}
+
+QString ArtifactCache::verifyAndCommit(const QString& sha)
+{
+    return QString("echo '%1  %1.part' | sha256sum -c --status && mv %1.part %1").arg(sha);
+}
+
+ArtifactCache::Marker ArtifactCache::parseMarker(const QString& line)
+{
+    if (line == "@@CAS hit") return Marker::Hit;
+    if (line == "@@CAS need") return Marker::Need;
+    if (line == "@@CAS delta") return Marker::Delta;
+    return Marker::None;
+}
+
+QString ArtifactCache::formatBytes(qint64 bytes)
+{
+    if (bytes < 1024) {
+        return QString("%1 Б").arg(bytes);
+    }
+    if (bytes < 1024 * 1024) {
+        return QString("%1 КБ").arg(bytes / 1024.0, 0, 'f', 1);
+    }
+    return QString("%1 МБ").arg(bytes / (1024.0 * 1024.0), 0, 'f', 1);
+}
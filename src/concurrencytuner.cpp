@@ -0,0 +1,160 @@
+#include "concurrencytuner.h"
+#include <QFile>
+#include <QDebug>
+#include <algorithm>
+#ifdef Q_OS_WIN
+#include "windows.h"
+#endif
+
+namespace {
+const int kSampleIntervalMs = 2000;
+const double kCpuHighLoad = 0.85;
+const double kCpuLowLoad = 0.60;
+}
+
+ConcurrencyTuner::ConcurrencyTuner(QObject *parent)
+    : QObject(parent)
+    , m_sampleTimer(new QTimer(this))
+    , m_concurrency(5)
+    , m_minimum(1)
+    , m_maximum(200)
+    , m_bestConcurrency(5)
+    , m_baselineLatencyMs(-1)
+    , m_lastIdleTime(0)
+    , m_lastTotalTime(0)
+{
+    m_sampleTimer->setInterval(kSampleIntervalMs);
+    connect(m_sampleTimer, &QTimer::timeout, this, &ConcurrencyTuner::onSampleTimer);
+}
+
+void ConcurrencyTuner::setLimits(int minimum, int maximum)
+{
+    m_minimum = qMax(1, minimum);
+    m_maximum = qMax(m_minimum, maximum);
+}
+
+void ConcurrencyTuner::start(int initialConcurrency)
+{
+    m_concurrency = qBound(m_minimum, initialConcurrency, m_maximum);
+    m_bestConcurrency = m_concurrency;
+    m_baselineLatencyMs = -1;
+    m_taskStartedAt.clear();
+    m_latencySamples.clear();
+    m_clock.start();
+
+    // Первый замер только запоминает счетчики CPU
+    sampleCpuLoad();
+    m_sampleTimer->start();
+}
+
+void ConcurrencyTuner::stop()
+{
+    m_sampleTimer->stop();
+}
+
+int ConcurrencyTuner::recommendedConcurrency() const
+{
+    return m_bestConcurrency;
+}
+
+void ConcurrencyTuner::taskStarted(const QString& host)
+{
+    m_taskStartedAt[host] = m_clock.elapsed();
+}
+
+void ConcurrencyTuner::taskFinished(const QString& host)
+{
+    auto it = m_taskStartedAt.find(host);
+    if (it == m_taskStartedAt.end()) return;
+
+    addLatencySample(m_clock.elapsed() - it.value());
+    m_taskStartedAt.erase(it);
+}
+
+void ConcurrencyTuner::addLatencySample(qint64 latencyMs)
+{
+    m_latencySamples.append(latencyMs);
+}
+
+qint64 ConcurrencyTuner::medianLatency()
+{
+    if (m_latencySamples.isEmpty()) return -1;
+
+    auto middle = m_latencySamples.begin() + m_latencySamples.size() / 2;
+    std::nth_element(m_latencySamples.begin(), middle, m_latencySamples.end());
+    return *middle;
+}
+
+void ConcurrencyTuner::onSampleTimer()
+{
+    double cpuLoad = sampleCpuLoad();
+    qint64 latency = medianLatency();
+    m_latencySamples.clear();
+
+    int next = m_concurrency;
+
+    if (cpuLoad > kCpuHighLoad) {
+        // Управляющая машина перегружена - снижаем мультипликативно
+        next = m_concurrency * 3 / 4;
+    } else if (latency >= 0) {
+        if (m_baselineLatencyMs < 0 || latency < m_baselineLatencyMs) {
+            m_baselineLatencyMs = latency;
+        }
+
+        if (latency > m_baselineLatencyMs * 3 / 2) {
+            next = m_concurrency * 3 / 4;
+        } else if (cpuLoad < kCpuLowLoad && latency <= m_baselineLatencyMs * 6 / 5) {
+            next = m_concurrency + 2;
+            m_bestConcurrency = m_concurrency;
+        }
+    }
+
+    next = qBound(m_minimum, next, m_maximum);
+    qDebug() << "Автоподбор параллельности: CPU" << cpuLoad << "задержка" << latency
+             << "мс, параллельность" << m_concurrency << "->" << next;
+
+    if (next != m_concurrency) {
+        if (next < m_concurrency) {
+            m_bestConcurrency = next;
+        }
+        m_concurrency = next;
+        emit concurrencyChanged(m_concurrency);
+    }
+}
+
+double ConcurrencyTuner::sampleCpuLoad()
+{
+    quint64 idleTime = 0;
+    quint64 totalTime = 0;
+
+#ifdef Q_OS_WIN
+    FILETIME idle, kernel, user;
+    if (!GetSystemTimes(&idle, &kernel, &user)) return 0.0;
+
+    auto toUInt64 = [](const FILETIME& time) {
+        return (static_cast<quint64>(time.dwHighDateTime) << 32) | time.dwLowDateTime;
+    };
+    idleTime = toUInt64(idle);
+    // Время ядра уже включает время простоя
+    totalTime = toUInt64(kernel) + toUInt64(user);
+#else
+    QFile stat("/proc/stat");
+    if (!stat.open(QIODevice::ReadOnly)) return 0.0;
+
+    QList<QByteArray> fields = stat.readLine().simplified().split(' ');
+    for (int i = 1; i < fields.size(); ++i) {
+        totalTime += fields[i].toULongLong();
+        if (i == 4 || i == 5) {
+            idleTime += fields[i].toULongLong();
+        }
+    }
+#endif
+
+    quint64 idleDelta = idleTime - m_lastIdleTime;
+    quint64 totalDelta = totalTime - m_lastTotalTime;
+    m_lastIdleTime = idleTime;
+    m_lastTotalTime = totalTime;
+
+    if (totalDelta == 0) return 0.0;
+    return 1.0 - static_cast<double>(idleDelta) / static_cast<double>(totalDelta);
+}
@@ -24,22 +24,46 @@ void ConfigManager::saveConfiguration(const QList<HostConfig>& hosts, const QStr
     QStringList hostsList;
     QStringList usersList;
     QStringList passwordsList;
+    QStringList portsList;
 
     for (int i = 0; i < hosts.size(); ++i) {
         hostsList << hosts[i].address;
         usersList << hosts[i].sshUser;
         passwordsList << hosts[i].sshPass;
+        portsList << QString::number(hosts[i].sshPort);
     }
 
     settings.setValue("hosts", hostsList);
     settings.setValue("ssh_users", usersList);
     settings.setValue("ssh_passwords", passwordsList);
+    settings.setValue("ssh_ports", portsList);
     settings.setValue("default_ssh_user", defaultUser);
 
     settings.sync();
     qDebug() << "Конфигурация сохранена. Хостов:" << hosts.size();
 }
 
+void ConfigManager::saveTuning(int concurrency, int batchSize)
+{
+    QSettings settings(configFilePath, QSettings::IniFormat);
+    settings.setValue("tuning/concurrency", concurrency);
+    settings.setValue("tuning/batch_size", batchSize);
+    settings.sync();
+}
+
+void ConfigManager::loadTuning(int& concurrency, int& batchSize)
+{
+    QSettings settings(configFilePath, QSettings::IniFormat);
+    concurrency = settings.value("tuning/concurrency", 5).toInt();
+    batchSize = settings.value("tuning/batch_size", 0).toInt();
+}
+
+QStringList ConfigManager::loadOutputPatterns()
+{
+    QSettings settings(configFilePath, QSettings::IniFormat);
+    return settings.value("output/patterns").toStringList();
+}
+
 void ConfigManager::loadConfiguration(QList<HostConfig>& hosts, QString& defaultUser)
 {
     QSettings settings(configFilePath, QSettings::IniFormat);
@@ -49,6 +73,7 @@ void ConfigManager::loadConfiguration(QList<HostConfig>& hosts, QString& default
     QStringList hostsList = settings.value("hosts").toStringList();
     QStringList usersList = settings.value("ssh_users").toStringList();
     QStringList passwordsList = settings.value("ssh_passwords").toStringList();
+    QStringList portsList = settings.value("ssh_ports").toStringList();
 
     hosts.clear();
     for (int i = 0; i < hostsList.size(); ++i) {
@@ -67,6 +92,10 @@ void ConfigManager::loadConfiguration(QList<HostConfig>& hosts, QString& default
             hostConfig.sshPass = QString();
         }
 
+        if (i < portsList.size() && portsList[i].toInt() > 0) {
+            hostConfig.sshPort = portsList[i].toInt();
+        }
+
         hosts.append(hostConfig);
     }
 
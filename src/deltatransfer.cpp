@@ -0,0 +1,296 @@
+#include "deltatransfer.h"
+#include <QCryptographicHash>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QVector>
+#include <cmath>
+
+namespace {
+const int kMinBlockSize = 2048;
+const int kMaxBlockSize = 64 * 1024;
+// Вставки кодируются кусками, кратными 57 байтам (= строка base64 из 76 символов)
+const int kLiteralChunk = 57 * 1024;
+
+struct PatchOp {
+    bool copy;
+    qint64 offset;
+    qint64 length;
+};
+
+// Слабая контрольная сумма rsync: две 16-битные суммы, пересчитываемые за O(1)
+// при сдвиге окна на байт
+struct RollingChecksum {
+    quint32 a = 0;
+    quint32 b = 0;
+    int length = 0;
+
+    void reset(const uchar *data, int len)
+    {
+        a = 0;
+        b = 0;
+        length = len;
+        for (int i = 0; i < len; ++i) {
+            a += data[i];
+            b += quint32(len - i) * data[i];
+        }
+        a &= 0xffff;
+        b &= 0xffff;
+    }
+
+    void roll(uchar out, uchar in)
+    {
+        a = (a - out + in) & 0xffff;
+        b = (b - quint32(length) * out + a) & 0xffff;
+    }
+
+    quint32 value() const { return a | (b << 16); }
+};
+
+QByteArray strongHash(const uchar *data, int len)
+{
+    return QCryptographicHash::hash(QByteArray::fromRawData(reinterpret_cast<const char*>(data), len),
+                                    QCryptographicHash::Md5);
+}
+
+void appendOp(QVector<PatchOp>& ops, bool copy, qint64 offset, qint64 length)
+{
+    // Соседние копирования подряд идущих блоков склеиваем в одну команду dd
+    if (!ops.isEmpty() && copy && ops.last().copy
+            && ops.last().offset + ops.last().length == offset) {
+        ops.last().length += length;
+        return;
+    }
+    ops.append({copy, offset, length});
+}
+
+QVector<PatchOp> computeOps(const uchar *base, qint64 baseSize,
+                            const uchar *data, qint64 size, int blockSize)
+{
+    QHash<quint32, QVector<int>> index;
+    QVector<QByteArray> strong;
+    int blockCount = int(baseSize / blockSize);
+    strong.resize(blockCount);
+
+    RollingChecksum checksum;
+    for (int i = 0; i < blockCount; ++i) {
+        const uchar *block = base + qint64(i) * blockSize;
+        checksum.reset(block, blockSize);
+        index[checksum.value()].append(i);
+        strong[i] = strongHash(block, blockSize);
+    }
+
+    QVector<PatchOp> ops;
+    qint64 pos = 0;
+    qint64 literalStart = 0;
+
+    if (size >= blockSize) {
+        checksum.reset(data, blockSize);
+    }
+
+    while (pos + blockSize <= size) {
+        int matched = -1;
+        auto it = index.constFind(checksum.value());
+        if (it != index.constEnd()) {
+            QByteArray hash = strongHash(data + pos, blockSize);
+            for (int candidate : it.value()) {
+                if (strong[candidate] == hash) {
+                    matched = candidate;
+                    break;
+                }
+            }
+        }
+
+        if (matched >= 0) {
+            if (literalStart < pos) {
+                appendOp(ops, false, literalStart, pos - literalStart);
+            }
+            appendOp(ops, true, qint64(matched) * blockSize, blockSize);
+            pos += blockSize;
+            literalStart = pos;
+            if (pos + blockSize <= size) {
+                checksum.reset(data + pos, blockSize);
+            }
+        } else {
+            if (pos + blockSize < size) {
+                checksum.roll(data[pos], data[pos + blockSize]);
+            }
+            ++pos;
+        }
+    }
+
+    if (literalStart < size) {
+        appendOp(ops, false, literalStart, size - literalStart);
+    }
+    return ops;
+}
+}
+
+QString DeltaTransfer::storeDir()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + "/artifacts";
+}
+
+bool DeltaTransfer::buildPatch(const QString& basePath, const QString& baseSha,
+                               const QString& newPath, const QString& newSha,
+                               const QString& patchPath, Stats* stats)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QFile baseFile(basePath);
+    QFile newFile(newPath);
+    if (!baseFile.open(QIODevice::ReadOnly) || !newFile.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    if (baseFile.size() == 0 || newFile.size() == 0) {
+        return false;
+    }
+
+    // Файлы отображаются в память, а не читаются целиком
+    const uchar *base = baseFile.map(0, baseFile.size());
+    const uchar *data = newFile.map(0, newFile.size());
+    if (!base || !data) {
+        return false;
+    }
+
+    int blockSize = qBound(kMinBlockSize, int(std::sqrt(double(baseFile.size()))), kMaxBlockSize);
+    QVector<PatchOp> ops = computeOps(base, baseFile.size(), data, newFile.size(), blockSize);
+
+    QFile patch(patchPath);
+    if (!patch.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+
+    qint64 copied = 0;
+    qint64 literal = 0;
+
+    patch.write(QString("# CpuStatCheck delta %1 -> %2\n").arg(baseSha, newSha).toLatin1());
+    patch.write("{\n");
+    for (const PatchOp& op : ops) {
+        if (op.copy) {
+            patch.write(QString("dd if=%1 bs=65536 iflag=skip_bytes,count_bytes skip=%2 count=%3 status=none\n")
+                        .arg(baseSha).arg(op.offset).arg(op.length).toLatin1());
+            copied += op.length;
+            continue;
+        }
+
+        patch.write("base64 -d <<'CPUSTAT_DELTA'\n");
+        for (qint64 offset = 0; offset < op.length; offset += kLiteralChunk) {
+            int chunk = int(qMin<qint64>(kLiteralChunk, op.length - offset));
+            QByteArray encoded = QByteArray::fromRawData(reinterpret_cast<const char*>(data + op.offset + offset),
+                                                         chunk).toBase64();
+            for (int i = 0; i < encoded.size(); i += 76) {
+                patch.write(encoded.constData() + i, qMin(76, encoded.size() - i));
+                patch.write("\n");
+            }
+        }
+        patch.write("CPUSTAT_DELTA\n");
+        literal += op.length;
+    }
+    patch.write(QString("} > %1.part\n").arg(newSha).toLatin1());
+    patch.close();
+
+    if (stats) {
+        stats->blockSize = blockSize;
+        stats->copiedBytes = copied;
+        stats->literalBytes = literal;
+        stats->patchSize = QFileInfo(patchPath).size();
+        stats->elapsedMs = timer.elapsed();
+    }
+    return true;
+}
+
+ArtifactCache::Delta DeltaTransfer::prepare(const ArtifactCache::Artifact& artifact, const QString& patchDir,
+                                            QString* summary)
+{
+    ArtifactCache::Delta delta;
+    if (!artifact.isValid()) {
+        return delta;
+    }
+
+    // Хранилище баз общее для всех запусков из очереди
+    static QMutex storeMutex;
+    QMutexLocker locker(&storeMutex);
+
+    QDir dir(storeDir());
+    if (!dir.mkpath(".")) {
+        return delta;
+    }
+    QDir outDir(patchDir.isEmpty() ? dir.path() : patchDir);
+    if (!outDir.mkpath(".")) {
+        return delta;
+    }
+
+    // Патчи, которые раньше писались прямо в хранилище, больше не нужны
+    const QStringList oldPatches = dir.entryList(QStringList() << "*.patch.sh", QDir::Files);
+    for (const QString& name : oldPatches) {
+        dir.remove(name);
+    }
+
+    QSettings index(dir.filePath("index.ini"), QSettings::IniFormat);
+    index.beginGroup("bases");
+    QString key = QFileInfo(artifact.localPath).fileName();
+    QString baseSha = index.value(key).toString();
+
+    if (baseSha == artifact.sha256) {
+        index.endGroup();
+        return delta;
+    }
+
+    QString basePath = dir.filePath(baseSha);
+    if (!baseSha.isEmpty() && QFile::exists(basePath)) {
+        QString patchPath = outDir.filePath(QString("%1-%2.patch.sh").arg(baseSha.left(12), artifact.sha256.left(12)));
+        Stats stats;
+        bool built = buildPatch(basePath, baseSha, artifact.localPath, artifact.sha256, patchPath, &stats);
+
+        // Патч, сравнимый по размеру с архивом, не дает выигрыша
+        if (built && stats.patchSize < artifact.size * 9 / 10) {
+            delta.baseSha = baseSha;
+            delta.patchPath = patchPath;
+            delta.patchSize = stats.patchSize;
+            if (summary) {
+                *summary = QString("🧬 Дельта архива: патч %1 из %2 (%3%), совпало %4, блок %5 Б, расчет %6 мс")
+                           .arg(ArtifactCache::formatBytes(stats.patchSize),
+                                ArtifactCache::formatBytes(artifact.size))
+                           .arg(100.0 * stats.patchSize / qMax<qint64>(1, artifact.size), 0, 'f', 1)
+                           .arg(ArtifactCache::formatBytes(stats.copiedBytes))
+                           .arg(stats.blockSize)
+                           .arg(stats.elapsedMs);
+            }
+        } else if (summary) {
+            *summary = "🧬 Дельта архива не дает выигрыша - архив будет передан целиком";
+        }
+    }
+
+    // Текущая версия становится базой для следующего запуска
+    QString currentPath = dir.filePath(artifact.sha256);
+    if (!QFile::exists(currentPath)) {
+        QFile::copy(artifact.localPath, currentPath);
+    }
+    index.setValue(key, artifact.sha256);
+
+    // Старую базу удаляем, если на нее не ссылается другой архив
+    if (!baseSha.isEmpty()) {
+        bool used = false;
+        const QStringList keys = index.childKeys();
+        for (const QString& other : keys) {
+            if (index.value(other).toString() == baseSha) {
+                used = true;
+                break;
+            }
+        }
+        if (!used) {
+            QFile::remove(basePath);
+        }
+    }
+    index.endGroup();
+
+    return delta;
+}
@@ -0,0 +1,51 @@
+#include "fanouttree.h"
+#include "artifactcache.h"
+#include "sshexecutor.h"
+
+FanoutTree::FanoutTree(int hostCount, int degree)
+    : m_hostCount(hostCount)
+    , m_degree(degree)
+{
+}
+
+bool FanoutTree::isEnabled() const
+{
+    // Если все хосты помещаются в сиды, дерево не нужно
+    return m_degree > 0 && m_hostCount > m_degree;
+}
+
+int FanoutTree::parent(int index) const
+{
+    if (!isEnabled() || index < m_degree) return -1;
+    return (index - m_degree) / m_degree;
+}
+
+int FanoutTree::tier(int index) const
+{
+    int level = 0;
+    for (int i = parent(index); i >= 0; i = parent(i)) {
+        ++level;
+    }
+    return level;
+}
+
+int FanoutTree::depth() const
+{
+    return m_hostCount > 0 && isEnabled() ? tier(m_hostCount - 1) : 0;
+}
+
+QString FanoutTree::relayCommand(const HostConfig& child, const QString& sha, const QString& childCommand)
+{
+    QString target = child.sshUser + "@" + child.address;
+    QString options = QString("-p %1 -o StrictHostKeyChecking=no -o UserKnownHostsFile=/dev/null "
+                              "-o LogLevel=ERROR -o ConnectTimeout=10").arg(child.sshPort);
+
+    // Ключ потомка берется из агента, проброшенного с управляющей машины (ssh -A);
+    // пароль потомка на родителя не передается
+    QString ssh = QString("ssh %1 -o BatchMode=yes").arg(options);
+
+    return QString("cd %1 && "
+                   "{ echo '%2  %2' | sha256sum -c --status || { echo @@RELAY bad-source; exit 96; }; }; "
+                   "%3 %4 %5 < %2")
+        .arg(ArtifactCache::remoteDir, sha, ssh, target, SshExecutor::shellQuote(childCommand));
+}
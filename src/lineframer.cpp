@@ -0,0 +1,34 @@
+#include "lineframer.h"
+
+LineFramer::LineFramer(int initialCapacity)
+    : m_buffer(initialCapacity, Qt::Uninitialized)
+    , m_begin(0)
+    , m_scan(0)
+    , m_end(0)
+    , m_totalBytes(0)
+    , m_busyNsecs(0)
+{
+}
+
+void LineFramer::clear()
+{
+    m_begin = m_scan = m_end = 0;
+}
+
+void LineFramer::reserve(int size)
+{
+    if (m_end + size <= m_buffer.size()) return;
+
+    // Сдвигаем только незавершенную строку - обычно это несколько байт
+    if (m_begin > 0) {
+        int tail = m_end - m_begin;
+        std::memmove(m_buffer.data(), m_buffer.constData() + m_begin, size_t(tail));
+        m_scan -= m_begin;
+        m_end = tail;
+        m_begin = 0;
+    }
+
+    if (m_end + size > m_buffer.size()) {
+        m_buffer.resize(qMax(m_end + size, m_buffer.size() * 2));
+    }
+}
@@ -0,0 +1,140 @@
+#include "logstore.h"
+#include <QDataStream>
+#include <QDebug>
+
+namespace {
+// Страниц, прочитанных с диска, держим столько, сколько видно на экране с запасом
+const int kCachePages = 4;
+// Очень длинные строки обрезаются: окно их все равно не покажет целиком
+const int kMaxLineLength = 8192;
+}
+
+LogStore::LogStore(int pageLines, int memoryPages, bool spillToDisk)
+    : m_pageLines(qMax(1, pageLines))
+    , m_memoryPages(qMax(1, memoryPages))
+    , m_spillToDisk(spillToDisk)
+    , m_lineCount(0)
+    , m_droppedPages(0)
+    , m_spillSize(0)
+{
+}
+
+void LogStore::append(const QString& text, Style style)
+{
+    if (m_pages.isEmpty() || m_pages.last().size() >= m_pageLines) {
+        if (m_pages.size() >= m_memoryPages) {
+            spillOldest();
+        }
+        m_pages.append(QVector<Line>());
+        m_pages.last().reserve(m_pageLines);
+    }
+
+    Line line;
+    line.text = text.size() > kMaxLineLength ? text.left(kMaxLineLength) + "…" : text;
+    line.style = style;
+    m_pages.last().append(line);
+    ++m_lineCount;
+}
+
+void LogStore::clear()
+{
+    m_pages.clear();
+    m_spilled.clear();
+    m_cache.clear();
+    m_lineCount = 0;
+    m_droppedPages = 0;
+    m_spillSize = 0;
+    if (m_spillFile.isOpen()) {
+        m_spillFile.resize(0);
+        m_spillFile.seek(0);
+    }
+}
+
+void LogStore::spillOldest()
+{
+    if (!m_spillToDisk) {
+        m_lineCount -= m_pages.first().size();
+        ++m_droppedPages;
+        m_pages.removeFirst();
+        return;
+    }
+
+    if (!m_spillFile.isOpen() && !m_spillFile.open()) {
+        // Диска нет - теряем самую старую страницу, но память не растет
+        qWarning() << "LogStore: не удалось создать временный файл журнала";
+        m_spilled.append({-1, 0});
+        m_pages.removeFirst();
+        return;
+    }
+
+    QByteArray raw;
+    QDataStream out(&raw, QIODevice::WriteOnly);
+    const QVector<Line>& page = m_pages.first();
+    out << qint32(page.size());
+    for (const Line& line : page) {
+        out << quint8(line.style) << line.text;
+    }
+
+    QByteArray packed = qCompress(raw, 1);
+    m_spillFile.seek(m_spillSize);
+    m_spillFile.write(packed);
+    m_spilled.append({m_spillSize, packed.size()});
+    m_spillSize += packed.size();
+    m_pages.removeFirst();
+}
+
+const QVector<LogStore::Line>& LogStore::cachedPage(qint64 page)
+{
+    for (int i = 0; i < m_cache.size(); ++i) {
+        if (m_cache[i].first == page) {
+            if (i != m_cache.size() - 1) {
+                m_cache.move(i, m_cache.size() - 1);
+            }
+            return m_cache.last().second;
+        }
+    }
+
+    QVector<Line> lines;
+    const SpilledPage& spilled = m_spilled.at(int(page));
+    QByteArray raw;
+    if (spilled.offset >= 0) {
+        m_spillFile.seek(spilled.offset);
+        raw = qUncompress(m_spillFile.read(spilled.size));
+    }
+
+    QDataStream in(raw);
+    qint32 count = 0;
+    in >> count;
+    lines.reserve(count);
+    for (qint32 i = 0; i < count; ++i) {
+        quint8 style = 0;
+        Line line;
+        in >> style >> line.text;
+        line.style = Style(style);
+        lines.append(line);
+    }
+
+    if (m_cache.size() >= kCachePages) {
+        m_cache.removeFirst();
+    }
+    m_cache.append(qMakePair(page, lines));
+    return m_cache.last().second;
+}
+
+LogStore::Line LogStore::line(qint64 index)
+{
+    if (index < 0 || index >= m_lineCount) return Line();
+
+    // Все страницы, кроме последней, полные; отбрасываются только целые страницы
+    qint64 page = index / m_pageLines + m_droppedPages;
+    int offset = int(index % m_pageLines);
+
+    qint64 firstInMemory = m_droppedPages + m_spilled.size();
+    if (page >= firstInMemory) {
+        const QVector<Line>& lines = m_pages.at(int(page - firstInMemory));
+        return offset < lines.size() ? lines.at(offset) : Line();
+    }
+
+    const QVector<Line>& lines = cachedPage(page - m_droppedPages);
+    return offset < lines.size() ? lines.at(offset) : Line();
+}
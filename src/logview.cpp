@@ -0,0 +1,215 @@
+#include "logview.h"
+#include <QPainter>
+#include <QRegularExpression>
+#include <QScrollBar>
+#include <climits>
+
+namespace {
+// Журнал хоста: 16 страниц по 1024 строки, старые отбрасываются
+const int kHostPageLines = 1024;
+const int kHostPages = 16;
+
+QString unescapeHtml(QString text)
+{
+    text.replace("&lt;", "<");
+    text.replace("&gt;", ">");
+    text.replace("&quot;", "\"");
+    text.replace("&#39;", "'");
+    text.replace("&amp;", "&");
+    return text;
+}
+}
+
+LogView::HostLog::HostLog()
+    : store(kHostPageLines, kHostPages, false)
+{
+}
+
+LogView::LogView(QWidget *parent)
+    : QAbstractScrollArea(parent)
+    , m_maxLineLength(0)
+    , m_current(&m_store)
+    , m_currentMaxLength(&m_maxLineLength)
+{
+    QFont font("Courier New");
+    font.setStyleHint(QFont::Monospace);
+    setFont(font);
+    viewport()->setBackgroundRole(QPalette::Base);
+    viewport()->setAutoFillBackground(true);
+    setHorizontalScrollBarPolicy(Qt::ScrollBarAsNeeded);
+    setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOn);
+}
+
+LogView::~LogView()
+{
+    qDeleteAll(m_hosts);
+}
+
+void LogView::appendParsed(LogStore& store, int& maxLineLength, const QString& text)
+{
+    // Прежний вывод размечал ошибки и совпадения шаблонов одним span на строку
+    static const QRegularExpression spanPattern("^<(?:span style|font color)='([^']*)'>(.*)</(?:span|font)>$");
+
+    LogStore::Style style = LogStore::Style::Normal;
+    QString plain = text;
+    if (text.startsWith('<')) {
+        QRegularExpressionMatch match = spanPattern.match(text);
+        if (match.hasMatch()) {
+            QString css = match.captured(1);
+            style = css.contains("background") ? LogStore::Style::Highlight : LogStore::Style::Error;
+            plain = unescapeHtml(match.captured(2));
+        }
+    }
+
+    // Многострочные сообщения раскладываются по строкам окна
+    const QStringList parts = plain.split('\n');
+    for (const QString& part : parts) {
+        store.append(part, style);
+        maxLineLength = qMax(maxLineLength, part.size());
+    }
+}
+
+bool LogView::isFollowing() const
+{
+    return verticalScrollBar()->value() >= verticalScrollBar()->maximum();
+}
+
+void LogView::refresh(bool follow)
+{
+    updateScrollBars();
+    if (follow) {
+        verticalScrollBar()->setValue(verticalScrollBar()->maximum());
+    }
+    viewport()->update();
+}
+
+void LogView::appendLine(const QString& text)
+{
+    appendLines(QStringList() << text);
+}
+
+void LogView::appendLines(const QStringList& lines)
+{
+    if (lines.isEmpty()) return;
+
+    bool follow = isFollowing();
+    for (const QString& line : lines) {
+        appendParsed(m_store, m_maxLineLength, line);
+    }
+
+    if (m_current == &m_store) {
+        refresh(follow);
+    }
+}
+
+void LogView::appendHostLine(const QString& host, const QString& task, const QString& text)
+{
+    HostLog *log = m_hosts.value(host);
+    if (!log) {
+        log = new HostLog();
+        m_hosts.insert(host, log);
+        emit hostAdded(host);
+    }
+
+    if (!task.isEmpty() && (log->tasks.isEmpty() || log->tasks.last().task != task)) {
+        log->tasks.append({task, log->store.firstLine() + log->store.lineCount()});
+        emit taskAdded(host, task);
+    }
+
+    bool follow = isFollowing();
+    appendParsed(log->store, log->maxLineLength, text);
+
+    if (m_current == &log->store) {
+        refresh(follow);
+    }
+}
+
+void LogView::clear()
+{
+    m_store.clear();
+    m_maxLineLength = 0;
+    qDeleteAll(m_hosts);
+    m_hosts.clear();
+    m_currentHost.clear();
+    m_current = &m_store;
+    m_currentMaxLength = &m_maxLineLength;
+    refresh(true);
+}
+
+void LogView::setCurrentHost(const QString& host)
+{
+    HostLog *log = m_hosts.value(host);
+    m_currentHost = log ? host : QString();
+    m_current = log ? &log->store : &m_store;
+    m_currentMaxLength = log ? &log->maxLineLength : &m_maxLineLength;
+    horizontalScrollBar()->setValue(0);
+    refresh(true);
+}
+
+QVector<LogView::TaskMark> LogView::tasks(const QString& host) const
+{
+    HostLog *log = m_hosts.value(host);
+    return log ? log->tasks : QVector<TaskMark>();
+}
+
+void LogView::scrollToTask(int index)
+{
+    HostLog *log = m_hosts.value(m_currentHost);
+    if (!log || index < 0 || index >= log->tasks.size()) return;
+
+    // Начало задачи могло уйти за пределы буфера - тогда показываем его начало
+    qint64 line = qMax<qint64>(0, log->tasks.at(index).line - log->store.firstLine());
+    verticalScrollBar()->setValue(int(qMin<qint64>(line, INT_MAX)));
+}
+
+int LogView::visibleRows() const
+{
+    return qMax(1, viewport()->height() / fontMetrics().lineSpacing());
+}
+
+void LogView::updateScrollBars()
+{
+    int rows = visibleRows();
+    qint64 maxFirst = qMax<qint64>(0, m_current->lineCount() - rows);
+    verticalScrollBar()->setPageStep(rows);
+    verticalScrollBar()->setSingleStep(1);
+    verticalScrollBar()->setRange(0, int(qMin<qint64>(maxFirst, INT_MAX)));
+
+    int charWidth = fontMetrics().horizontalAdvance('M');
+    int contentWidth = *m_currentMaxLength * charWidth + 8;
+    horizontalScrollBar()->setPageStep(viewport()->width());
+    horizontalScrollBar()->setSingleStep(charWidth * 4);
+    horizontalScrollBar()->setRange(0, qMax(0, contentWidth - viewport()->width()));
+}
+
+void LogView::resizeEvent(QResizeEvent *event)
+{
+    bool follow = isFollowing();
+    QAbstractScrollArea::resizeEvent(event);
+    refresh(follow);
+}
+
+void LogView::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event)
+
+    QPainter painter(viewport());
+    const QFontMetrics metrics = fontMetrics();
+    const int lineHeight = metrics.lineSpacing();
+    const int x = 4 - horizontalScrollBar()->value();
+    const int width = viewport()->width();
+    const QColor normalColor = palette().color(QPalette::Text);
+
+    qint64 first = verticalScrollBar()->value();
+    qint64 last = qMin(m_current->lineCount(), first + visibleRows() + 1);
+
+    int y = 0;
+    for (qint64 i = first; i < last; ++i, y += lineHeight) {
+        LogStore::Line line = m_current->line(i);
+        if (line.style == LogStore::Style::Highlight) {
+            painter.fillRect(0, y, width, lineHeight, QColor("#fff3b0"));
+        }
+        painter.setPen(line.style == LogStore::Style::Error ? QColor(Qt::red) : normalColor);
+        painter.drawText(x, y + metrics.ascent(), line.text);
+    }
+}
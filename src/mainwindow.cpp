@@ -11,6 +11,7 @@
 #include <QDropEvent>
 #include <QUrl>
 #include <QTimer>
+#include <QDateTime>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
@@ -23,9 +24,8 @@ MainWindow::MainWindow(QWidget *parent)
     setCentralWidget(graphics);
     checker = new WSLChecker(this);
     configManager = new ConfigManager(this);
-    ansibleRunner = new AnsibleRunner(this);
-
-    ansibleRunner->setProgressManager(graphics->getProgressManager());
+    runQueue = new RunQueue(this);
+    runQueue->setProgressManager(graphics->getProgressManager());
 
     loadSavedConfiguration();
     setupConnections();
@@ -38,11 +38,22 @@ MainWindow::MainWindow(QWidget *parent)
     playbookPath = QDir::cleanPath(playbookPath);
     
     qDebug() << "Playbook path:" << playbookPath;
-    ansibleRunner->setPlaybookPath(playbookPath);
-
-    connect(ansibleRunner, &AnsibleRunner::outputReceived, this, &MainWindow::onAnsibleOutput);
-    connect(ansibleRunner, &AnsibleRunner::finished, this, &MainWindow::onAnsibleFinished);
-    connect(ansibleRunner, &AnsibleRunner::errorOccurred, this, &MainWindow::onAnsibleError);
+    runQueue->setPlaybookPath(playbookPath);
+
+    connect(runQueue, &RunQueue::linesReady, graphics, &WindowGraphics::appendOutputLines);
+    connect(runQueue, &RunQueue::outputReceived, graphics, &WindowGraphics::appendOutput);
+    connect(runQueue, &RunQueue::hostOutputReceived, graphics, &WindowGraphics::appendHostOutput);
+    connect(runQueue, &RunQueue::errorOccurred, this, &MainWindow::onAnsibleError);
+    connect(runQueue, &RunQueue::tuningRecorded, configManager, &ConfigManager::saveTuning);
+    connect(runQueue, &RunQueue::connectionStateChanged, this, &MainWindow::onConnectionStateChanged);
+    connect(runQueue, &RunQueue::scriptStaged, this, &MainWindow::onScriptStaged);
+    connect(runQueue, &RunQueue::archiveStaged, this, &MainWindow::onArchiveStaged);
+    connect(runQueue, &RunQueue::hostProgressChanged, this, &MainWindow::onHostProgressChanged);
+    connect(runQueue, &RunQueue::hostEtaChanged, this, &MainWindow::onHostEtaChanged);
+    connect(runQueue, &RunQueue::hostReachability, this, &MainWindow::onHostReachability);
+    connect(runQueue, &RunQueue::jobChanged, this, &MainWindow::onRunJobChanged);
+    connect(runQueue, &RunQueue::jobRemoved, graphics, &WindowGraphics::removeRunQueueItem);
+    connect(runQueue, &RunQueue::idle, this, &MainWindow::onRunQueueIdle);
     connect(checker, SIGNAL(wslSetupFinished(bool)),
             this, SLOT(onWslSetupFinished(bool)));
     
@@ -71,6 +82,14 @@ void MainWindow::setupConnections()
     connect(graphics->getAddHostButton(), &QPushButton::clicked, this, &MainWindow::onAddHostClicked);
     connect(graphics->getRemoveHostButton(), &QPushButton::clicked, this, &MainWindow::removeHost);
     connect(graphics->getPlayButton(), &QPushButton::clicked, this, &MainWindow::onPlayButtonClicked);
+    connect(graphics->getCancelRunButton(), &QPushButton::clicked, this, &MainWindow::onCancelRunClicked);
+    connect(graphics->getMaxRunsSpinBox(), QOverload<int>::of(&QSpinBox::valueChanged), this, [this](int count) {
+        runQueue->setMaxConcurrent(count);
+    });
+    connect(graphics->getRetryFailedButton(), &QPushButton::clicked, this, &MainWindow::onRetryFailedClicked);
+    connect(graphics->getRetriesSpinBox(), QOverload<int>::of(&QSpinBox::valueChanged), this, [this](int retries) {
+        runQueue->setRetryPolicy(retries);
+    });
 }
 
 void MainWindow::loadSavedConfiguration()
@@ -81,6 +100,12 @@ void MainWindow::loadSavedConfiguration()
     for (const auto& host : hostsConfig) {
         graphics->addHostToList(host.address + " (" + host.sshUser + "@" + host.address + ")");
     }
+
+    int concurrency = 0;
+    int batchSize = 0;
+    configManager->loadTuning(concurrency, batchSize);
+    runQueue->setRecordedConcurrency(concurrency);
+    graphics->getBatchSizeSpinBox()->setValue(batchSize);
 }
 
 void MainWindow::checkWSLAndShowStatus()
@@ -102,6 +127,9 @@ void MainWindow::checkWSLAndShowStatus()
         if (info.hasDistributions) {
             QString status = "WSL готов: " + info.distributions.join(", ");
             graphics->appendStatusBar(status);
+
+            // Поднимаем контроллер Ansible заранее, чтобы первый запуск был "теплым"
+            runQueue->warmUpController();
         } else {
             graphics->appendStatusBar("WSL установлен, но нет дистрибутивов");
             QTimer::singleShot(500, checker, &WSLChecker::showWslSetupDialog);
@@ -155,16 +183,40 @@ void MainWindow::onWslCheckError(const QString &error)
 
 void MainWindow::setArchivePath(const QString& path)
 {
-    currentArchivePath = path;
-    QFileInfo fileInfo(path);
-    
     if (!path.isEmpty()) {
-        if (ansibleRunner->updateArchivePathInPlaybook(playbookPath, path)) {
-            graphics->appendOutput("📦 Путь к архиву обновлен: " + fileInfo.fileName());
-            graphics->updateFilePathLabel("Архив загружен: " + fileInfo.fileName(), true);
-        } else {
-            graphics->appendOutput("❌ Не удалось обновить путь к архиву");
-        }
+        // Файл проверяется в рабочем потоке, итог - onArchiveStaged
+        runQueue->stageArchive(path);
+    }
+}
+
+void MainWindow::onArchiveStaged(bool success, const QString& archivePath)
+{
+    if (!success) {
+        graphics->appendOutput("❌ Архив не найден: " + archivePath);
+        return;
+    }
+
+    currentArchivePath = archivePath;
+    QString fileName = QFileInfo(archivePath).fileName();
+    graphics->appendOutput("📦 Архив выбран: " + fileName);
+    graphics->updateFilePathLabel("Архив загружен: " + fileName, true);
+}
+
+void MainWindow::onScriptStaged(bool success, const QString& scriptPath, const QString& archivePath)
+{
+    if (!success) {
+        graphics->updateFilePathLabel("Не удалось подготовить скрипт", false);
+        return;
+    }
+
+    currentFilePath = scriptPath;
+    currentScriptName = pendingScriptName;
+    currentArchivePath = archivePath;
+    graphics->updateFilePathLabel("Выбран скрипт: " + pendingScriptName
+                                  + (archivePath.isEmpty() ? "" : ", найден архив"), true);
+
+    if (!archivePath.isEmpty()) {
+        graphics->appendOutput("📦 Архив добавлен: " + QFileInfo(archivePath).fileName());
     }
 }
 
@@ -180,28 +232,9 @@ void MainWindow::dropEvent(QDropEvent *event)
             QFileInfo fileInfo(filePath);
 
             if (fileInfo.isFile() && fileInfo.suffix() == "sh") {
-                QString convertedPath;
-                QString archivePath;
-                
-                // ВАЖНО: Передаем указатель на archivePath, а не ссылку
-                if (ansibleRunner->convertScriptToUnixFormat(filePath, convertedPath, &archivePath)) {
-                    currentFilePath = convertedPath;
-                    currentArchivePath = archivePath;
-                    
-                    graphics->updateFilePathLabel("Выбран скрипт: " + fileInfo.fileName() + " (сконвертирован)", true);
-
-                    // Обновляем пути в playbook
-                    if (ansibleRunner->updateScriptPathInPlaybook(playbookPath, currentFilePath)) {
-                        qDebug() << "Script path updated in playbook";
-                    }
-                    
-                    if (!archivePath.isEmpty()) {
-                        if (ansibleRunner->updateArchivePathInPlaybook(playbookPath, archivePath)) {
-                            qDebug() << "Archive path updated in playbook";
-                            graphics->appendOutput("📦 Архив добавлен: " + QFileInfo(archivePath).fileName());
-                        }
-                    }
-                }
+                // Конвертация и поиск архива - в рабочем потоке
+                pendingScriptName = fileInfo.fileName();
+                runQueue->stageScript(filePath);
             }
             else if (fileInfo.suffix() == "gz" || fileInfo.suffix() == "tgz" || 
                      fileInfo.suffix() == "tar" || fileInfo.suffix() == "zip") {
@@ -212,35 +245,11 @@ void MainWindow::dropEvent(QDropEvent *event)
                 // Обработка папки - ищем скрипт и архив
                 QDir dir(filePath);
                 QStringList scripts = dir.entryList(QStringList() << "*.sh", QDir::Files);
-                QStringList archives = dir.entryList(QStringList() << "*.tar.gz" << "*.tgz" << "*.tar" << "*.zip", QDir::Files);
                 
                 if (!scripts.isEmpty()) {
-                    QString scriptPath = dir.absoluteFilePath(scripts.first());
-                    QString archivePath = archives.isEmpty() ? QString() : dir.absoluteFilePath(archives.first());
-                    
-                    QString convertedPath;
-                    // ВАЖНО: Передаем указатель на archivePath
-                    if (ansibleRunner->updateScriptPathInPlaybook(playbookPath, currentFilePath)) {
-                        currentFilePath = convertedPath;
-                        currentArchivePath = archivePath;
-                        
-                        graphics->updateFilePathLabel(
-                            "Выбрана папка: " + fileInfo.fileName() + 
-                            (archivePath.isEmpty() ? "" : " (найден архив)"), 
-                            true
-                        );
-
-                        if (ansibleRunner->updateScriptPathInPlaybook(playbookPath, currentFilePath)) {
-                            qDebug() << "Script path updated in playbook";
-                        }
-                        
-                        if (!archivePath.isEmpty()) {
-                            if (ansibleRunner->updateArchivePathInPlaybook(playbookPath, archivePath)) {
-                                qDebug() << "Archive path updated in playbook";
-                                graphics->appendOutput("📦 Архив найден: " + QFileInfo(archivePath).fileName());
-                            }
-                        }
-                    }
+                    // Архив ищется рядом со скриптом при подготовке
+                    pendingScriptName = fileInfo.fileName() + "/" + scripts.first();
+                    runQueue->stageScript(dir.absoluteFilePath(scripts.first()));
                 } else {
                     graphics->updateFilePathLabel("В папке не найдено .sh файлов", false);
                 }
@@ -264,7 +273,19 @@ void MainWindow::onAddHostClicked()
         }
 
         HostConfig host;
-        host.address = graphics->getNewHostEdit()->text();
+        host.address = graphics->getNewHostEdit()->text().trimmed();
+
+        // Поддерживаем запись вида host:port (например, 127.0.0.1:2222)
+        int colonIndex = host.address.lastIndexOf(':');
+        if (colonIndex > 0 && host.address.indexOf(':') == colonIndex) {
+            bool portOk = false;
+            int port = host.address.mid(colonIndex + 1).toInt(&portOk);
+            if (portOk && port > 0 && port < 65536) {
+                host.sshPort = port;
+                host.address = host.address.left(colonIndex);
+            }
+        }
+
         host.sshUser = graphics->getSshUserEdit()->text();
         host.sshPass = graphics->getSshPasswordEdit()->text(); // Сохраняем пароль
 
@@ -331,21 +352,129 @@ void MainWindow::onPlayButtonClicked()
         return;
     }
 
-    graphics->clearOutput();
-    ansibleRunner->setHosts(hostsConfig);
-    ansibleRunner->setScriptPath(currentFilePath);
-    ansibleRunner->executePlaybook();
+    // Журнал и статусы хостов очищаются только перед новой серией запусков;
+    // запуск, поставленный во время выполнения, дописывается в тот же журнал
+    if (runQueue->isIdle()) {
+        graphics->clearOutput();
+        const QList<QString> progressHosts = hostProgress.keys();
+        hostProgress.clear();
+        hostEta.clear();
+        for (const QString& endpoint : progressHosts) {
+            refreshHostStatus(endpoint);
+        }
+    }
+
+    RunSettings settings;
+    settings.hosts = hostsConfig;
+    settings.scriptPath = currentFilePath;
+    settings.archivePath = currentArchivePath;
+    settings.batchSize = graphics->getBatchSizeSpinBox()->value();
+    settings.forks = graphics->getConcurrencySpinBox()->value();
+    settings.fusedMode = graphics->getFusedCheckBox()->isChecked();
+    settings.streamArchive = graphics->getStreamArchiveCheckBox()->isChecked();
+    settings.liveOutput = graphics->getLiveOutputCheckBox()->isChecked();
+    settings.fanoutDegree = graphics->getFanoutSpinBox()->value();
+    settings.canarySize = graphics->getCanarySpinBox()->value();
+    settings.maxFailPercent = graphics->getMaxFailSpinBox()->value();
+    settings.taskTimeoutSec = graphics->getTaskTimeoutSpinBox()->value();
+    settings.hostTimeoutSec = graphics->getHostTimeoutSpinBox()->value();
+    settings.preflightTimeoutMs = graphics->getPreflightSpinBox()->value();
+    settings.outputPatterns = configManager->loadOutputPatterns();
+    settings.engine = graphics->getEngineComboBox()->currentIndex() == 1
+                      ? AnsibleRunner::Engine::NativeSsh
+                      : AnsibleRunner::Engine::AnsiblePlaybook;
+    runQueue->enqueue(settings, currentScriptName);
+}
+
+void MainWindow::onRunJobChanged(int jobId)
+{
+    const RunQueue::Job *job = runQueue->job(jobId);
+    if (job) {
+        graphics->setRunQueueItem(jobId, runQueue->describe(*job));
+    }
 }
 
-void MainWindow::onAnsibleOutput(const QString& text)
+void MainWindow::onRunQueueIdle()
 {
-    graphics->appendOutput(text);
+    graphics->appendStatusBar("Очередь запусков пуста");
 }
 
-void MainWindow::onAnsibleFinished(bool success, int exitCode)
+void MainWindow::onRetryFailedClicked()
 {
-    Q_UNUSED(success)
-    Q_UNUSED(exitCode)
+    QListWidgetItem *item = graphics->getRunQueueListWidget()->currentItem();
+    if (!item) {
+        showMessage("Выберите запуск в очереди", true);
+        return;
+    }
+    if (!runQueue->retryFailed(item->data(Qt::UserRole).toInt())) {
+        showMessage("У запуска нет хостов с ошибкой, или он еще выполняется", true);
+    }
+}
+
+void MainWindow::onCancelRunClicked()
+{
+    QListWidgetItem *item = graphics->getRunQueueListWidget()->currentItem();
+    if (!item) {
+        showMessage("Выберите запуск в очереди", true);
+        return;
+    }
+    runQueue->cancel(item->data(Qt::UserRole).toInt());
+}
+
+void MainWindow::onConnectionStateChanged(const QString& endpoint, const QString& stateText)
+{
+    hostConnectionStates.insert(endpoint, stateText);
+    refreshHostStatus(endpoint);
+}
+
+void MainWindow::onHostProgressChanged(const QString& endpoint, int percent)
+{
+    hostProgress.insert(endpoint, percent);
+    refreshHostStatus(endpoint);
+}
+
+void MainWindow::onHostEtaChanged(const QString& endpoint, qint64 remainingMs, bool slow)
+{
+    hostEta.insert(endpoint, qMakePair(remainingMs, slow));
+    refreshHostStatus(endpoint);
+}
+
+void MainWindow::onHostReachability(const QString& endpoint, bool reachable, qint64 latencyMs)
+{
+    hostReachability.insert(endpoint, reachable ? latencyMs : -1);
+    refreshHostStatus(endpoint);
+}
+
+void MainWindow::refreshHostStatus(const QString& endpoint)
+{
+    QString status;
+    if (hostReachability.contains(endpoint)) {
+        qint64 latency = hostReachability.value(endpoint);
+        status = latency >= 0 ? QString("🟢 %1 мс").arg(latency) : QString("🔴 SSH-порт не отвечает");
+    }
+    const QString connectionState = hostConnectionStates.value(endpoint);
+    if (!connectionState.isEmpty()) {
+        status += status.isEmpty() ? connectionState : "   " + connectionState;
+    }
+    if (hostProgress.contains(endpoint)) {
+        status += QString(status.isEmpty() ? "%1%" : "   %1%").arg(hostProgress.value(endpoint));
+    }
+    if (hostEta.contains(endpoint)) {
+        const QPair<qint64, bool> eta = hostEta.value(endpoint);
+        if (eta.first > 0) {
+            status += QString("   ~%1 (к %2)").arg(ProgressManager::formatDuration(eta.first),
+                                                    QDateTime::currentDateTime().addMSecs(eta.first).toString("HH:mm"));
+        }
+        if (eta.second) {
+            status += "   🐢 медленнее обычного";
+        }
+    }
+
+    for (int i = 0; i < hostsConfig.size(); ++i) {
+        if (hostsConfig[i].endpoint() == endpoint) {
+            graphics->setHostStatus(i, status);
+        }
+    }
 }
 
 void MainWindow::onAnsibleError(const QString& message)
@@ -0,0 +1,144 @@
+#include "outputmatcher.h"
+#include <QElapsedTimer>
+#include <QQueue>
+
+OutputMatcher::OutputMatcher()
+    : m_scannedBytes(0)
+    , m_busyNsecs(0)
+{
+}
+
+void OutputMatcher::addPattern(const QByteArray& pattern, quint32 category, bool anchored)
+{
+    if (pattern.isEmpty()) return;
+    m_patterns.append({pattern, category, anchored, -1});
+}
+
+int OutputMatcher::addUserPattern(const QByteArray& pattern)
+{
+    if (pattern.isEmpty() || m_userPatterns.size() >= maxUserPatterns) return -1;
+
+    int index = m_userPatterns.size();
+    m_userPatterns.append(pattern);
+    m_patterns.append({pattern, UserPattern, false, index});
+    return index;
+}
+
+int OutputMatcher::addState(int depth)
+{
+    m_next.resize(m_next.size() + 256);
+    std::fill(m_next.end() - 256, m_next.end(), -1);
+    m_depth.append(depth);
+    m_output.append(0);
+    m_anchoredOutput.append(0);
+    m_userOutput.append(0);
+    return m_depth.size() - 1;
+}
+
+void OutputMatcher::build()
+{
+    m_next.clear();
+    m_depth.clear();
+    m_output.clear();
+    m_anchoredOutput.clear();
+    m_userOutput.clear();
+    addState(0);
+
+    // Бор шаблонов
+    for (const Pattern& pattern : m_patterns) {
+        int state = 0;
+        for (char ch : pattern.text) {
+            int slot = state * 256 + uchar(ch);
+            if (m_next[slot] < 0) {
+                int created = addState(m_depth[state] + 1);
+                m_next[slot] = created;
+            }
+            state = m_next[slot];
+        }
+        if (pattern.anchored) {
+            m_anchoredOutput[state] |= pattern.category;
+        } else {
+            m_output[state] |= pattern.category;
+            if (pattern.userIndex >= 0) {
+                m_userOutput[state] |= quint64(1) << pattern.userIndex;
+            }
+        }
+    }
+
+    // Суффиксные ссылки обходом в ширину; недостающие переходы замыкаем,
+    // получая автомат без возвратов
+    QVector<int> fail(m_depth.size(), 0);
+    QQueue<int> queue;
+    for (int ch = 0; ch < 256; ++ch) {
+        int& next = m_next[ch];
+        if (next < 0) {
+            next = 0;
+        } else {
+            fail[next] = 0;
+            queue.enqueue(next);
+        }
+    }
+
+    while (!queue.isEmpty()) {
+        int state = queue.dequeue();
+        int link = fail[state];
+        m_output[state] |= m_output[link];
+        m_userOutput[state] |= m_userOutput[link];
+
+        for (int ch = 0; ch < 256; ++ch) {
+            int& next = m_next[state * 256 + ch];
+            int fallback = m_next[link * 256 + ch];
+            if (next < 0) {
+                next = fallback;
+            } else {
+                fail[next] = fallback;
+                queue.enqueue(next);
+            }
+        }
+    }
+}
+
+quint32 OutputMatcher::classify(const char *data, int size, quint64 *userMatches) const
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    quint32 categories = 0;
+    quint64 user = 0;
+    int state = 0;
+    const int *next = m_next.constData();
+    for (int i = 0; i < size; ++i) {
+        state = next[state * 256 + uchar(data[i])];
+        categories |= m_output[state];
+        user |= m_userOutput[state];
+        // Глубина i + 1 значит, что путь в автомате идет от начала строки
+        if (m_depth[state] == i + 1) {
+            categories |= m_anchoredOutput[state];
+        }
+    }
+
+    if (userMatches) {
+        *userMatches = user;
+    }
+    m_scannedBytes += size;
+    m_busyNsecs += timer.nsecsElapsed();
+    return categories;
+}
+
+OutputMatcher OutputMatcher::forAnsible(const QStringList& userPatterns)
+{
+    OutputMatcher matcher;
+    matcher.addPattern("TASK [", TaskHeader, true);
+    matcher.addPattern("PLAY RECAP", PlayRecap, true);
+    matcher.addPattern("fatal: [", Fatal, true);
+    matcher.addPattern("UNREACHABLE!", Unreachable);
+    matcher.addPattern("FAILED!", Failed);
+    matcher.addPattern("[WARNING]", Warning, true);
+    matcher.addPattern("@@CAS-STATS", CasStats);
+    matcher.addPattern("@@STEP", BundleStep);
+    for (const QString& pattern : userPatterns) {
+        matcher.addUserPattern(pattern.trimmed().toUtf8());
+    }
+    matcher.build();
+    return matcher;
+}
@@ -0,0 +1,55 @@
+#include "processtree.h"
+#include <QFile>
+#include <QPointer>
+#include <QTimer>
+
+namespace {
+// Группа процессов и все ее потомки (рабочие процессы ansible могут уйти
+// в свою группу): сначала SIGTERM, затем, если кто-то жив после паузы, SIGKILL
+const char *kTerminateScript =
+    "f=\"$1\"; steps=\"$2\"; pg=$(cat \"$f\" 2>/dev/null); rm -f \"$f\"; [ -n \"$pg\" ] || exit 0; "
+    "tree() { local c; for c in $(ps -o pid= --ppid \"$1\"); do tree \"$c\"; done; echo \"$1\"; }; "
+    "pids=$(tree \"$pg\"); "
+    "alive() { local p; for p in $pids; do kill -0 \"$p\" 2>/dev/null && return 0; done; return 1; }; "
+    "kill -TERM -- -\"$pg\" $pids 2>/dev/null; "
+    "i=0; while [ $i -lt \"$steps\" ] && alive; do sleep 0.1; i=$((i + 1)); done; "
+    "kill -KILL -- -\"$pg\" $pids 2>/dev/null; exit 0";
+}
+
+QStringList ProcessTree::wrap(const QString& pidFile, const QStringList& command)
+{
+    // -e: аргументы передаются без разбора оболочкой; setsid -w ждет команду,
+    // чтобы wsl.exe жил, пока она выполняется. Номер группы ($$ оболочки,
+    // которую заменяет exec) пишется до запуска самой команды
+    QStringList args;
+    args << "-e" << "setsid" << "-w" << "sh" << "-c" << "echo $$ > \"$0\" && exec \"$@\""
+         << toWslPath(pidFile) << command;
+    return args;
+}
+
+void ProcessTree::terminate(QProcess *process, const QString& pidFile, int graceMs)
+{
+    if (!pidFile.isEmpty()) {
+        QStringList args;
+        args << "-e" << "bash" << "-c" << kTerminateScript << "cpustat-kill"
+             << toWslPath(pidFile) << QString::number(qMax(1, graceMs / 100));
+        QProcess::startDetached("wsl", args);
+    }
+
+    if (!process || process->state() == QProcess::NotRunning) return;
+
+    // Дерево в WSL остановлено - wsl.exe выходит сам; если нет, добиваем его
+    QPointer<QProcess> guard = process;
+    QTimer::singleShot(graceMs + 2000, process, [guard]() {
+        if (guard && guard->state() != QProcess::NotRunning) {
+            guard->kill();
+        }
+    });
+}
+
+void ProcessTree::release(const QString& pidFile)
+{
+    if (!pidFile.isEmpty()) {
+        QFile::remove(pidFile);
+    }
+}
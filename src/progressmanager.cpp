@@ -1,5 +1,16 @@
 #include "progressmanager.h"
 #include <QApplication>
+#include <QDateTime>
+
+QString ProgressManager::formatDuration(qint64 msecs)
+{
+    qint64 seconds = (msecs + 999) / 1000;
+    if (seconds >= 3600) {
+        return QString("%1:%2:%3").arg(seconds / 3600)
+            .arg(seconds / 60 % 60, 2, 10, QChar('0')).arg(seconds % 60, 2, 10, QChar('0'));
+    }
+    return QString("%1:%2").arg(seconds / 60).arg(seconds % 60, 2, 10, QChar('0'));
+}
 
 ProgressManager::ProgressManager(QObject *parent)
     : QObject(parent)
@@ -47,6 +58,7 @@ void ProgressManager::startProgress(int maxSteps)
         m_progressBar->setVisible(true);
         m_progressBar->setRange(0, 100);
         m_progressBar->setValue(0);
+        m_progressBar->setFormat("%p%");
         m_progressBar->setStyleSheet(
             "QProgressBar {"
             "    border: 1px solid #bbb;"
@@ -76,6 +88,10 @@ void ProgressManager::stopProgress(bool success)
     m_isIndeterminateMode = false;
     m_indeterminateTimer->stop();
     
+    if (m_progressBar) {
+        m_progressBar->setFormat("%p%");
+    }
+
     if (success) {
         m_progressValue = 100;
         if (m_progressBar) {
@@ -171,6 +187,37 @@ void ProgressManager::setStatusText(const QString& text)
     emit statusChanged(text);
 }
 
+void ProgressManager::updateHostProgress(const QString& endpoint, int percent)
+{
+    if (!m_isRunning) return;
+
+    emit hostProgressChanged(endpoint, qBound(0, percent, 100));
+}
+
+void ProgressManager::updateHostEta(const QString& endpoint, qint64 remainingMs, bool slow)
+{
+    if (!m_isRunning) return;
+
+    emit hostEtaChanged(endpoint, qMax<qint64>(0, remainingMs), slow);
+}
+
+void ProgressManager::setEta(qint64 remainingMs)
+{
+    if (!m_isRunning) return;
+
+    if (remainingMs < 0) {
+        // Истории нет - экстраполируем по прошедшему времени
+        if (m_progressValue <= 0 || !m_elapsedTimer.isValid()) return;
+        remainingMs = m_elapsedTimer.elapsed() * (100 - m_progressValue) / m_progressValue;
+    }
+
+    if (m_progressBar) {
+        QString finish = QDateTime::currentDateTime().addMSecs(remainingMs).toString("HH:mm");
+        m_progressBar->setFormat(QString("%p% · осталось ~%1 (к %2)").arg(formatDuration(remainingMs), finish));
+    }
+    emit etaChanged(remainingMs);
+}
+
 void ProgressManager::reset()
 {
     m_isRunning = false;
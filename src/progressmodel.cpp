@@ -0,0 +1,360 @@
+#include "progressmodel.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRegularExpression>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QTextStream>
+#include <cmath>
+
+QHash<QString, ProgressModel::Plan> ProgressModel::s_plans;
+// Запуски из очереди разбирают планы в своих потоках
+static QMutex s_plansMutex;
+
+namespace {
+// Вес задачи без истории, мс
+const double kDefaultWeight = 1000.0;
+// Доля нового наблюдения в скользящем среднем
+const double kSmoothing = 0.3;
+// Хост "медленный", если задача идет дольше среднего на 3 сигмы...
+const double kSlowSigmas = 3.0;
+// ...но не меньше чем вдвое и на 2 с дольше обычного (короткие задачи шумят)
+const double kSlowFactor = 2.0;
+const double kSlowMarginMs = 2000.0;
+
+// QSettings считает '/' разделителем групп, а задачи могут его содержать
+QString settingsKey(const QString& task)
+{
+    QString key = task;
+    key.replace('/', '|');
+    key.replace('\\', '|');
+    return key;
+}
+}
+
+void ProgressModel::Estimate::add(double value)
+{
+    if (samples == 0) {
+        mean = value;
+        variance = 0.0;
+    } else {
+        // Экспоненциально взвешенные среднее и дисперсия
+        double delta = value - mean;
+        mean += kSmoothing * delta;
+        variance = (1.0 - kSmoothing) * (variance + kSmoothing * delta * delta);
+    }
+    ++samples;
+}
+
+double ProgressModel::Estimate::slowThreshold() const
+{
+    double threshold = qMax(mean * kSlowFactor, mean + kSlowMarginMs);
+    // По одному-двум наблюдениям дисперсия ничего не говорит
+    if (samples >= 3) {
+        threshold = qMax(threshold, mean + kSlowSigmas * std::sqrt(variance));
+    }
+    return threshold;
+}
+
+ProgressModel::ProgressModel()
+    : m_totalWeight(0.0)
+    , m_doneTotal(0.0)
+{
+}
+
+QStringList ProgressModel::parseTasks(const QString& playbookPath)
+{
+    QStringList tasks;
+    QFile file(playbookPath);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return tasks;
+    }
+
+    // Полный разбор YAML не нужен: задачи - это элементы "- name:" на уровне
+    // отступа первой задачи после "tasks:"
+    static const QRegularExpression tasksRegex("^(\\s*)tasks:\\s*$");
+    static const QRegularExpression nameRegex("^(\\s*)- name:\\s*(.+?)\\s*$");
+
+    QTextStream stream(&file);
+    stream.setCodec("UTF-8");
+    int tasksIndent = -1;
+    int itemIndent = -1;
+    while (!stream.atEnd()) {
+        QString line = stream.readLine();
+
+        QRegularExpressionMatch match = tasksRegex.match(line);
+        if (match.hasMatch()) {
+            tasksIndent = match.capturedLength(1);
+            itemIndent = -1;
+            continue;
+        }
+        if (tasksIndent < 0) continue;
+
+        match = nameRegex.match(line);
+        if (!match.hasMatch()) continue;
+
+        int indent = match.capturedLength(1);
+        if (indent <= tasksIndent - 2) {
+            // Следующий play
+            tasksIndent = -1;
+            continue;
+        }
+        if (itemIndent < 0) itemIndent = indent;
+        if (indent != itemIndent) continue;
+
+        QString name = match.captured(2);
+        if (name.size() >= 2 && (name.startsWith('"') || name.startsWith('\''))
+                && name.endsWith(name.at(0))) {
+            name = name.mid(1, name.size() - 2);
+        }
+        tasks << name;
+    }
+    return tasks;
+}
+
+bool ProgressModel::load(const QString& playbookPath)
+{
+    QFileInfo info(playbookPath);
+    QString key = info.absoluteFilePath();
+
+    QMutexLocker locker(&s_plansMutex);
+    auto it = s_plans.find(key);
+    if (it == s_plans.end() || it->modified != info.lastModified() || it->size != info.size()) {
+        Plan plan;
+        plan.modified = info.lastModified();
+        plan.size = info.size();
+        plan.tasks = parseTasks(playbookPath);
+        it = s_plans.insert(key, plan);
+    }
+
+    m_playbookName = info.fileName();
+    m_tasks = it->tasks;
+    locker.unlock();
+    m_taskIndex.clear();
+    for (int i = 0; i < m_tasks.size(); ++i) {
+        m_taskIndex.insert(m_tasks[i], i);
+    }
+    loadWeights();
+    return !m_tasks.isEmpty();
+}
+
+QString ProgressModel::durationsPath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + "/task_durations.ini";
+}
+
+QString ProgressModel::hostDurationsPath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + "/host_durations.ini";
+}
+
+void ProgressModel::loadHostHistory()
+{
+    // Формат значения: "среднее;дисперсия;число наблюдений"
+    QSettings settings(hostDurationsPath(), QSettings::IniFormat);
+    settings.beginGroup(m_playbookName);
+    for (auto it = m_hostRuns.begin(); it != m_hostRuns.end(); ++it) {
+        it->history.fill(Estimate(), m_tasks.size());
+        settings.beginGroup(settingsKey(it.key()));
+        for (int i = 0; i < m_tasks.size(); ++i) {
+            const QStringList parts = settings.value(settingsKey(m_tasks[i])).toString().split(';');
+            if (parts.size() != 3) continue;
+            Estimate& estimate = it->history[i];
+            estimate.mean = parts[0].toDouble();
+            estimate.variance = parts[1].toDouble();
+            estimate.samples = parts[2].toInt();
+        }
+        settings.endGroup();
+    }
+    settings.endGroup();
+}
+
+void ProgressModel::loadWeights()
+{
+    QSettings settings(durationsPath(), QSettings::IniFormat);
+    settings.beginGroup(m_playbookName);
+
+    m_weights.fill(0.0, m_tasks.size());
+    m_totalWeight = 0.0;
+    for (int i = 0; i < m_tasks.size(); ++i) {
+        // Не меньше 50 мс, чтобы мгновенные задачи тоже двигали прогресс
+        m_weights[i] = qMax(50.0, settings.value(settingsKey(m_tasks[i]), kDefaultWeight).toDouble());
+        m_totalWeight += m_weights[i];
+    }
+    settings.endGroup();
+}
+
+void ProgressModel::reset(const QStringList& hosts)
+{
+    m_done.clear();
+    m_doneWeight.clear();
+    m_doneTotal = 0.0;
+    m_observed.clear();
+    m_hostRuns.clear();
+    for (const QString& host : hosts) {
+        m_done.insert(host, QVector<bool>(m_tasks.size(), false));
+        m_doneWeight.insert(host, 0.0);
+        m_hostRuns.insert(host, HostRun());
+    }
+    loadHostHistory();
+    m_clock.start();
+}
+
+void ProgressModel::hostTaskStarted(const QString& host, const QString& task)
+{
+    auto index = m_taskIndex.constFind(task);
+    auto run = m_hostRuns.find(host);
+    if (index == m_taskIndex.constEnd() || run == m_hostRuns.end()) return;
+
+    run->currentTask = *index;
+    run->currentStart = m_clock.elapsed();
+}
+
+void ProgressModel::hostResult(const QString& host, const QString& task, qint64 durationMs)
+{
+    auto index = m_taskIndex.constFind(task);
+    auto done = m_done.find(host);
+    // Задачи из include_tasks в плане отсутствуют
+    if (index == m_taskIndex.constEnd() || done == m_done.end()) return;
+
+    QPair<qint64, int>& observed = m_observed[task];
+    observed.first += durationMs;
+    ++observed.second;
+
+    HostRun& run = m_hostRuns[host];
+    run.observed.insert(*index, durationMs);
+    const Estimate& estimate = run.history.value(*index);
+    if (estimate.samples > 0 && durationMs > estimate.slowThreshold()) {
+        run.slowTask = task;
+    }
+    if (run.currentTask == *index) {
+        run.currentTask = -1;
+    }
+
+    if (done->at(*index)) return;
+    (*done)[*index] = true;
+    m_doneWeight[host] += m_weights[*index];
+    m_doneTotal += m_weights[*index];
+}
+
+void ProgressModel::hostFinished(const QString& host)
+{
+    auto done = m_done.find(host);
+    if (done == m_done.end()) return;
+
+    for (int i = 0; i < done->size(); ++i) {
+        if (done->at(i)) continue;
+        (*done)[i] = true;
+        m_doneWeight[host] += m_weights[i];
+        m_doneTotal += m_weights[i];
+    }
+    m_hostRuns[host].currentTask = -1;
+}
+
+int ProgressModel::percent() const
+{
+    double total = m_totalWeight * m_done.size();
+    if (total <= 0.0) return 0;
+    return qMin(100, int(m_doneTotal * 100.0 / total));
+}
+
+int ProgressModel::hostPercent(const QString& host) const
+{
+    if (m_totalWeight <= 0.0) return 0;
+    return qMin(100, int(m_doneWeight.value(host) * 100.0 / m_totalWeight));
+}
+
+double ProgressModel::expected(const HostRun& run, int task) const
+{
+    // Своя история хоста точнее общего веса задачи
+    const Estimate& estimate = run.history.value(task);
+    return estimate.samples > 0 ? estimate.mean : m_weights.value(task);
+}
+
+qint64 ProgressModel::expectedMs(const QString& host, const QString& task) const
+{
+    auto index = m_taskIndex.constFind(task);
+    auto run = m_hostRuns.constFind(host);
+    if (index == m_taskIndex.constEnd() || run == m_hostRuns.constEnd()) return 0;
+    return qint64(expected(*run, *index));
+}
+
+qint64 ProgressModel::hostRemainingMs(const QString& host) const
+{
+    auto done = m_done.constFind(host);
+    auto run = m_hostRuns.constFind(host);
+    if (done == m_done.constEnd() || run == m_hostRuns.constEnd()) return 0;
+
+    double remaining = 0.0;
+    for (int i = 0; i < done->size(); ++i) {
+        if (!done->at(i)) remaining += expected(*run, i);
+    }
+    // Текущая задача уже частично выполнена
+    if (run->currentTask >= 0 && !done->at(run->currentTask)) {
+        double elapsed = double(m_clock.elapsed() - run->currentStart);
+        remaining -= qMin(elapsed, expected(*run, run->currentTask));
+    }
+    return qint64(qMax(0.0, remaining));
+}
+
+qint64 ProgressModel::remainingMs() const
+{
+    qint64 remaining = 0;
+    for (auto it = m_done.constBegin(); it != m_done.constEnd(); ++it) {
+        remaining = qMax(remaining, hostRemainingMs(it.key()));
+    }
+    return remaining;
+}
+
+QString ProgressModel::slowTask(const QString& host) const
+{
+    auto run = m_hostRuns.constFind(host);
+    if (run == m_hostRuns.constEnd()) return QString();
+
+    if (run->currentTask >= 0) {
+        const Estimate& estimate = run->history.value(run->currentTask);
+        if (estimate.samples > 0 && m_clock.elapsed() - run->currentStart > estimate.slowThreshold()) {
+            return m_tasks.at(run->currentTask);
+        }
+    }
+    return run->slowTask;
+}
+
+void ProgressModel::saveDurations()
+{
+    if (m_observed.isEmpty()) return;
+
+    QSettings hostSettings(hostDurationsPath(), QSettings::IniFormat);
+    hostSettings.beginGroup(m_playbookName);
+    for (auto it = m_hostRuns.begin(); it != m_hostRuns.end(); ++it) {
+        if (it->observed.isEmpty()) continue;
+        hostSettings.beginGroup(settingsKey(it.key()));
+        for (auto obs = it->observed.constBegin(); obs != it->observed.constEnd(); ++obs) {
+            Estimate& estimate = it->history[obs.key()];
+            estimate.add(double(obs.value()));
+            hostSettings.setValue(settingsKey(m_tasks[obs.key()]),
+                                  QString("%1;%2;%3").arg(estimate.mean, 0, 'f', 1)
+                                                     .arg(estimate.variance, 0, 'f', 1)
+                                                     .arg(estimate.samples));
+        }
+        it->observed.clear();
+        hostSettings.endGroup();
+    }
+    hostSettings.endGroup();
+
+    QSettings settings(durationsPath(), QSettings::IniFormat);
+    settings.beginGroup(m_playbookName);
+    for (auto it = m_observed.constBegin(); it != m_observed.constEnd(); ++it) {
+        if (it->second <= 0) continue;
+        double mean = double(it->first) / it->second;
+        QString key = settingsKey(it.key());
+        double weight = settings.contains(key)
+            ? settings.value(key).toDouble() * (1.0 - kSmoothing) + mean * kSmoothing
+            : mean;
+        settings.setValue(key, weight);
+    }
+    settings.endGroup();
+    loadWeights();
+}
@@ -0,0 +1,148 @@
+#include "reachabilityprober.h"
+#include <QSet>
+#include <QTcpSocket>
+
+ReachabilityProber::ReachabilityProber(QObject *parent)
+    : QObject(parent)
+    , m_nextTarget(0)
+    , m_deadlineTimer(new QTimer(this))
+    , m_timeoutMs(1500)
+    , m_maxInFlight(256)
+    , m_running(false)
+{
+    connect(m_deadlineTimer, &QTimer::timeout, this, &ReachabilityProber::checkDeadlines);
+}
+
+ReachabilityProber::~ReachabilityProber()
+{
+    abort();
+}
+
+void ReachabilityProber::setTimeout(int ms)
+{
+    m_timeoutMs = qMax(100, ms);
+}
+
+void ReachabilityProber::setMaxInFlight(int count)
+{
+    m_maxInFlight = qMax(1, count);
+}
+
+void ReachabilityProber::start(const QList<HostConfig>& hosts)
+{
+    abort();
+
+    m_targets.clear();
+    m_results.clear();
+    QSet<QString> seen;
+    for (const HostConfig& host : hosts) {
+        if (!seen.contains(host.endpoint())) {
+            seen.insert(host.endpoint());
+            m_targets.append(host);
+        }
+    }
+
+    m_nextTarget = 0;
+    m_running = true;
+    if (m_targets.isEmpty()) {
+        m_running = false;
+        emit finished();
+        return;
+    }
+
+    // Сроки проверяются одним таймером, а не таймером на каждое подключение
+    m_deadlineTimer->setInterval(qBound(20, m_timeoutMs / 10, 100));
+    m_deadlineTimer->start();
+    launchNext();
+}
+
+void ReachabilityProber::abort()
+{
+    m_deadlineTimer->stop();
+    for (Probe& probe : m_inFlight) {
+        probe.socket->disconnect(this);
+        probe.socket->abort();
+        probe.socket->deleteLater();
+    }
+    m_inFlight.clear();
+    m_running = false;
+}
+
+void ReachabilityProber::launchNext()
+{
+    while (m_running && m_inFlight.size() < m_maxInFlight && m_nextTarget < m_targets.size()) {
+        const HostConfig& host = m_targets[m_nextTarget++];
+
+        Probe probe;
+        probe.endpoint = host.endpoint();
+        probe.socket = new QTcpSocket(this);
+        connect(probe.socket, &QTcpSocket::connected, this, &ReachabilityProber::onConnected);
+        connect(probe.socket, QOverload<QAbstractSocket::SocketError>::of(&QAbstractSocket::error),
+                this, &ReachabilityProber::onSocketError);
+        probe.timer.start();
+        // В списке до connectToHost: ошибка может прийти сразу из него
+        m_inFlight.append(probe);
+        probe.socket->connectToHost(host.address, quint16(host.sshPort));
+    }
+}
+
+void ReachabilityProber::onConnected()
+{
+    complete(qobject_cast<QTcpSocket*>(sender()), true, QString());
+}
+
+void ReachabilityProber::onSocketError()
+{
+    QTcpSocket *socket = qobject_cast<QTcpSocket*>(sender());
+    complete(socket, false, socket ? socket->errorString() : QString());
+}
+
+void ReachabilityProber::checkDeadlines()
+{
+    QList<QTcpSocket*> expired;
+    for (const Probe& probe : m_inFlight) {
+        if (probe.timer.elapsed() > m_timeoutMs) {
+            expired.append(probe.socket);
+        }
+    }
+    for (QTcpSocket *socket : expired) {
+        complete(socket, false, QString("нет ответа за %1 мс").arg(m_timeoutMs));
+    }
+}
+
+void ReachabilityProber::complete(QTcpSocket *socket, bool reachable, const QString& error)
+{
+    int index = findProbe(socket);
+    if (index < 0) return;
+
+    Probe probe = m_inFlight.takeAt(index);
+    Result result;
+    result.reachable = reachable;
+    result.latencyMs = reachable ? probe.timer.elapsed() : -1;
+    result.error = error;
+    m_results.insert(probe.endpoint, result);
+
+    // Подключение нужно было только для проверки - сразу закрываем
+    socket->disconnect(this);
+    socket->abort();
+    socket->deleteLater();
+
+    emit hostProbed(probe.endpoint, reachable, result.latencyMs);
+
+    launchNext();
+    if (m_running && m_inFlight.isEmpty() && m_nextTarget >= m_targets.size()) {
+        m_running = false;
+        m_deadlineTimer->stop();
+        emit finished();
+    }
+}
+
+int ReachabilityProber::findProbe(QTcpSocket *socket) const
+{
+    for (int i = 0; i < m_inFlight.size(); ++i) {
+        if (m_inFlight[i].socket == socket) {
+            return i;
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,217 @@
+#include "remotebundle.h"
+#include <QFileInfo>
+#include <QRegularExpression>
+
+// Пути на целевой машине (совпадают с переменными ansible.yml)
+const char *RemoteBundle::scriptDest = "/tmp/deployed_script.sh";
+const char *RemoteBundle::archiveDest = "/tmp/deployed_archive.tar.gz";
+const char *RemoteBundle::resultDir = "/tmp/cpu_stat_results";
+
+RemoteBundle::RemoteBundle()
+{
+}
+
+void RemoteBundle::setScriptContent(const QByteArray& script)
+{
+    m_scriptContent = script;
+}
+
+void RemoteBundle::setArchiveName(const QString& archiveName)
+{
+    m_archiveName = archiveName;
+}
+
+void RemoteBundle::setArchiveStreamed(bool streamed)
+{
+    m_archiveStreamed = streamed;
+}
+
+QString RemoteBundle::extractDirFor(const QString& archiveName)
+{
+    return QString("/tmp/%1").arg(QFileInfo(archiveName).completeBaseName());
+}
+
+QString RemoteBundle::tarExtractFlags(const QString& archiveName)
+{
+    QString lower = archiveName.toLower();
+    if (lower.endsWith(".gz") || lower.endsWith(".tgz")) {
+        return "-xzf";
+    }
+    return "-xf";
+}
+
+bool RemoteBundle::canStream(const QString& archiveName)
+{
+    QString lower = archiveName.toLower();
+    return lower.endsWith(".tar") || lower.endsWith(".tar.gz") || lower.endsWith(".tgz");
+}
+
+QString RemoteBundle::manifestCommand(const QString& archiveName)
+{
+    QString dir = "'" + QString(extractDirFor(archiveName)).replace("'", "'\\''") + "'";
+    return QString("{ find %1 -type f | wc -l; du -sb %1 | cut -f1; } > %1.manifest && "
+                   "xargs printf 'files: %s, bytes: %s\\n' < %1.manifest")
+        .arg(dir);
+}
+
+QStringList RemoteBundle::stepIds() const
+{
+    QStringList ids;
+    ids << "stage";
+    if (!m_archiveName.isEmpty() && !m_archiveStreamed) {
+        ids << "extract";
+    }
+    ids << "execute" << "report";
+    if (!m_archiveName.isEmpty()) {
+        ids << "collect";
+    }
+    return ids;
+}
+
+QString RemoteBundle::stepTitle(const QString& id)
+{
+    if (id == "stage") return "Подготовка скрипта";
+    if (id == "extract") return "Распаковка архива";
+    if (id == "execute") return "Выполнение скрипта";
+    if (id == "report") return "Сохранение результатов";
+    if (id == "collect") return "Копирование файлов в результаты";
+    return id;
+}
+
+bool RemoteBundle::parseStepLine(const QString& line, StepStatus& status)
+{
+    static const QRegularExpression stepRegex("@@STEP (start|end) (\\w+)(?: (-?\\d+) (\\d+))?");
+
+    QRegularExpressionMatch match = stepRegex.match(line);
+    if (!match.hasMatch()) return false;
+
+    status.id = match.captured(2);
+    status.finished = match.captured(1) == "end";
+    status.exitCode = match.captured(3).toInt();
+    status.durationMs = match.captured(4).toLongLong();
+    return true;
+}
+
+QString RemoteBundle::build() const
+{
+    bool withArchive = !m_archiveName.isEmpty();
+    QString extractDir = extractDirFor(m_archiveName);
+
+    QStringList lines;
+    lines << "#!/bin/bash";
+    lines << "# CpuStatCheck: все шаги развертывания за одно SSH-подключение";
+    lines << "host=\"${BUNDLE_HOST:-$(hostname)}\"";
+    lines << QString("script_dest='%1'").arg(scriptDest);
+    lines << QString("archive_dest='%1'").arg(archiveDest);
+    lines << QString("result_dir='%1'").arg(resultDir);
+    lines << QString("extract_dir='%1'").arg(QString(extractDir).replace("'", "'\\''"));
+    lines << "bundle_steps=''";
+    lines << "script_rc=0";
+    lines << "extract_out='(no files extracted)'";
+    lines << "out_file=$(mktemp)";
+    lines << "err_file=$(mktemp)";
+    lines << "";
+    lines << "now_ms() { date +%s%3N; }";
+    // Имя хоста попадает в JSON итоговой строки - экранируется
+    lines << "json_escape() { local s=${1//\\\\/\\\\\\\\}; s=${s//\\\"/\\\\\\\"}; s=${s//$'\\n'/\\\\n}; s=${s//$'\\r'/\\\\r}; s=${s//$'\\t'/\\\\t}; printf '%s' \"$s\"; }";
+    lines << "";
+    lines << "run_step() {";
+    lines << "  local id=\"$1\"; shift";
+    lines << "  local started=$(now_ms)";
+    lines << "  echo \"@@STEP start $id\"";
+    lines << "  \"$@\"";
+    lines << "  local rc=$?";
+    lines << "  local elapsed=$(( $(now_ms) - started ))";
+    lines << "  echo \"@@STEP end $id $rc $elapsed\"";
+    lines << "  bundle_steps=\"$bundle_steps{\\\"id\\\":\\\"$id\\\",\\\"rc\\\":$rc,\\\"ms\\\":$elapsed},\"";
+    lines << "  return $rc";
+    lines << "}";
+    lines << "";
+    lines << "step_stage() {";
+    if (!m_scriptContent.isEmpty()) {
+        lines << "  base64 -d > \"$script_dest\" <<'CPUSTAT_SCRIPT_EOF' || return 1";
+        const QByteArray encoded = m_scriptContent.toBase64();
+        for (int i = 0; i < encoded.size(); i += 76) {
+            lines << QString::fromLatin1(encoded.mid(i, 76));
+        }
+        lines << "CPUSTAT_SCRIPT_EOF";
+    }
+    lines << "  [ -f \"$script_dest\" ] || return 1";
+    lines << "  sed -i 's/\\r$//' \"$script_dest\" 2>/dev/null || true";
+    lines << "  chmod 755 \"$script_dest\"";
+    lines << "}";
+    lines << "";
+    // Вместо полного листинга каталога - компактный манифест
+    lines << "read_manifest() {";
+    lines << "  [ -f \"$extract_dir.manifest\" ] || return 0";
+    lines << "  extract_out=\"files: $(sed -n 1p \"$extract_dir.manifest\"), bytes: $(sed -n 2p \"$extract_dir.manifest\")\"";
+    lines << "}";
+    lines << "";
+    lines << "step_extract() {";
+    lines << "  mkdir -p \"$extract_dir\" || return 1";
+    lines << QString("  (cd \"$extract_dir\" && tar %1 \"$archive_dest\") || { echo \"Extraction failed\"; return 1; }")
+             .arg(tarExtractFlags(m_archiveName));
+    lines << "  { find \"$extract_dir\" -type f | wc -l; du -sb \"$extract_dir\" | cut -f1; } > \"$extract_dir.manifest\"";
+    lines << "  read_manifest";
+    lines << "}";
+    lines << "";
+    lines << "step_execute() {";
+    // Сценарий приходит на хост через stdin (bash -s): скрипт его не наследует,
+    // иначе read/cat в скрипте съели бы оставшиеся шаги.
+    // stdout и stderr идут построчно по мере выполнения и одновременно
+    // сохраняются для отчета; stderr дописывается в файл до возврата из шага
+    lines << "  local linebuf=";
+    lines << "  command -v stdbuf >/dev/null && linebuf='stdbuf -oL -eL'";
+    lines << "  { $linebuf bash \"$script_dest\" </dev/null | $linebuf tee \"$out_file\"";
+    lines << "    script_rc=${PIPESTATUS[0]}; } 2> >($linebuf tee \"$err_file\" >&2)";
+    lines << "  wait $! 2>/dev/null";
+    lines << "  return $script_rc";
+    lines << "}";
+    lines << "";
+    lines << "step_report() {";
+    lines << "  mkdir -p \"$result_dir\" || return 1";
+    lines << "  {";
+    lines << "    echo \"Host: $host\"";
+    lines << "    echo \"Execution time: $(date -Iseconds)\"";
+    lines << "    echo";
+    lines << "    echo '========== SCRIPT EXECUTION =========='";
+    lines << "    cat \"$out_file\"";
+    lines << "    echo";
+    lines << "    echo '========== STDERR =========='";
+    lines << "    cat \"$err_file\"";
+    lines << "    echo";
+    lines << "    echo '========== EXIT CODE =========='";
+    lines << "    echo \"$script_rc\"";
+    lines << "    echo";
+    lines << "    echo '========== EXTRACTED FILES =========='";
+    lines << "    echo \"$extract_out\"";
+    lines << "    echo";
+    lines << "    echo '========== END OF REPORT =========='";
+    lines << "  } > \"$result_dir/$host.txt\"";
+    lines << "}";
+    lines << "";
+    lines << "step_collect() {";
+    lines << "  cp -r \"$extract_dir\"/* \"$result_dir\"/ 2>/dev/null || true";
+    lines << "}";
+    lines << "";
+    lines << "bundle_rc=0";
+    lines << "run_step stage step_stage || bundle_rc=$?";
+    if (withArchive && m_archiveStreamed) {
+        lines << "read_manifest";
+    } else if (withArchive) {
+        // Ошибка распаковки, как и в ansible.yml, не останавливает запуск скрипта
+        lines << "run_step extract step_extract";
+    }
+    lines << "if [ \"$bundle_rc\" -eq 0 ]; then";
+    lines << "  run_step execute step_execute || bundle_rc=$?";
+    lines << "fi";
+    lines << "run_step report step_report";
+    if (withArchive) {
+        lines << "run_step collect step_collect";
+    }
+    lines << "rm -f \"$out_file\" \"$err_file\"";
+    lines << "echo \"@@BUNDLE-RESULT {\\\"host\\\":\\\"$(json_escape \"$host\")\\\",\\\"rc\\\":$bundle_rc,\\\"steps\\\":[${bundle_steps%,}]}\"";
+    lines << "exit $bundle_rc";
+
+    return lines.join("\n") + "\n";
+}
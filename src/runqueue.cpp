@@ -0,0 +1,745 @@
+#include "runqueue.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QRandomGenerator>
+#include <QTimer>
+
+namespace {
+// Сколько завершенных запусков держать в списке очереди
+const int kFinishedKept = 20;
+// Верхняя граница паузы перед повтором, мс
+const int kMaxRetryDelayMs = 5 * 60 * 1000;
+
+bool isActive(RunQueue::State state)
+{
+    return state == RunQueue::State::Queued || state == RunQueue::State::Running
+           || state == RunQueue::State::RetryWaiting;
+}
+}
+
+RunQueue::RunQueue(QObject *parent)
+    : QObject(parent)
+    , m_stager(new RunWorker(this))
+    , m_connectionPool(new SshConnectionPool(this))
+    , m_progressManager(nullptr)
+    , m_recordedConcurrency(0)
+    , m_warm(false)
+    , m_maxConcurrent(1)
+    , m_nextId(1)
+    , m_maxRetries(0)
+    , m_retryBaseDelayMs(5000)
+    , m_batchFailed(false)
+{
+    connect(m_stager, &RunWorker::outputReceived, this, &RunQueue::outputReceived);
+    connect(m_stager, &RunWorker::errorOccurred, this, &RunQueue::errorOccurred);
+    connect(m_stager, &RunWorker::scriptStaged, this, &RunQueue::scriptStaged);
+    connect(m_stager, &RunWorker::archiveStaged, this, &RunQueue::archiveStaged);
+    connect(m_connectionPool, &SshConnectionPool::hostStateChanged, this,
+            [this](const QString& endpoint, SshConnectionPool::State state) {
+        emit connectionStateChanged(endpoint, SshConnectionPool::stateText(state));
+    });
+}
+
+RunQueue::~RunQueue()
+{
+    // Рабочие потоки останавливаются в деструкторах RunWorker; раньше пула
+    // подключений, на который ссылаются их раннеры
+    qDeleteAll(m_workers);
+    m_workers.clear();
+    m_idleWorkers.clear();
+    for (const Job& job : m_jobs) {
+        QDir(job.settings.stagingDir).removeRecursively();
+    }
+}
+
+void RunQueue::setProgressManager(ProgressManager *manager)
+{
+    m_progressManager = manager;
+}
+
+void RunQueue::setPlaybookPath(const QString& path)
+{
+    m_playbookPath = path;
+    m_stager->setPlaybookPath(path);
+    for (RunWorker *worker : m_workers) {
+        worker->setPlaybookPath(path);
+    }
+}
+
+void RunQueue::setRecordedConcurrency(int concurrency)
+{
+    m_recordedConcurrency = concurrency;
+    for (RunWorker *worker : m_workers) {
+        worker->setRecordedConcurrency(concurrency);
+    }
+}
+
+void RunQueue::warmUpController()
+{
+    m_warm = true;
+    if (m_workers.isEmpty()) {
+        // Первый исполнитель поднимается заранее, чтобы первый запуск был "теплым"
+        m_idleWorkers.append(acquireWorker());
+        return;
+    }
+    for (RunWorker *worker : m_workers) {
+        worker->warmUpController();
+    }
+}
+
+void RunQueue::setMaxConcurrent(int count)
+{
+    m_maxConcurrent = qMax(1, count);
+    schedule();
+}
+
+void RunQueue::setRetryPolicy(int maxRetries, int baseDelayMs)
+{
+    m_maxRetries = qMax(0, maxRetries);
+    m_retryBaseDelayMs = qMax(0, baseDelayMs);
+}
+
+QString RunQueue::stagingDirFor(int jobId) const
+{
+    // pid в пути: несколько копий программы не делят каталоги
+    return QDir::temp().absoluteFilePath(QString("cpustat-runs/%1-%2")
+                                         .arg(QCoreApplication::applicationPid())
+                                         .arg(jobId));
+}
+
+int RunQueue::enqueue(RunSettings settings, const QString& label)
+{
+    if (isIdle()) {
+        // Новая серия запусков: сводный прогресс считается заново
+        m_batchFailed = false;
+        for (Job& job : m_jobs) {
+            job.inBatch = false;
+        }
+        for (int i = 0; i < m_jobs.size() && m_jobs.size() > kFinishedKept; ) {
+            if (isActive(m_jobs[i].state)) {
+                ++i;
+                continue;
+            }
+            const int removedId = m_jobs[i].id;
+            releaseStaging(m_jobs[i], false);
+            delete m_jobs[i].progress;
+            delete m_jobs[i].updates;
+            m_jobs.removeAt(i);
+            emit jobRemoved(removedId);
+        }
+    }
+
+    Job job;
+    job.id = m_nextId++;
+    job.label = label.isEmpty() ? QFileInfo(settings.scriptPath).fileName() : label;
+    settings.stagingDir = stagingDirFor(job.id);
+
+    // Снимок скрипта в Unix-формате - в каталоге запуска: правка исходного
+    // файла или следующий перетащенный скрипт на запуск не влияют
+    if (!settings.scriptPath.isEmpty()) {
+        QString snapshot = QDir(settings.stagingDir).absoluteFilePath(QFileInfo(settings.scriptPath).fileName());
+        QString error;
+        if (!QDir().mkpath(settings.stagingDir)
+            || !AnsibleRunner::convertScriptToUnixFormat(settings.scriptPath, snapshot, &error)) {
+            if (error.isEmpty()) {
+                error = "Не удалось создать каталог запуска: " + QDir::toNativeSeparators(settings.stagingDir);
+            }
+            QDir(settings.stagingDir).removeRecursively();
+            emit errorOccurred(error);
+            emit outputReceived(QString("❌ Запуск не поставлен в очередь: %1").arg(error));
+            return -1;
+        }
+        settings.scriptPath = snapshot;
+    } else {
+        QDir().mkpath(settings.stagingDir);
+    }
+
+    if (settings.canarySize > 0 && settings.canarySize < settings.hosts.size()
+        && settings.maxFailPercent >= 100) {
+        // Канарейки без порога ничего не проверяют: тогда они должны пройти без ошибок.
+        // Замена порога не молчаливая - о ней сообщается в журнале
+        emit outputReceived(QString("⚠️ Запуск #%1: порог ошибок 100% не останавливает волны, "
+                                    "для канареечного запуска он заменен на 0%").arg(job.id));
+        settings.maxFailPercent = 0;
+    }
+    job.settings = settings;
+    job.allHosts = settings.hosts;
+    for (const HostConfig& host : settings.hosts) {
+        job.endpoints.insert(host.endpoint());
+    }
+    if (settings.canarySize > 0 && settings.canarySize < settings.hosts.size()) {
+        // Остальные хосты ждут итога канареек; они уже числятся за запуском
+        job.pending = settings.hosts.mid(settings.canarySize);
+        job.settings.hosts = settings.hosts.mid(0, settings.canarySize);
+        emit outputReceived(QString("🐤 Запуск #%1: сначала канареечные хосты (%2 из %3), порог ошибок %4%")
+                            .arg(job.id).arg(settings.canarySize).arg(settings.hosts.size())
+                            .arg(settings.maxFailPercent));
+    }
+
+    job.progress = new ProgressManager(this);
+    job.updates = new UpdateCoalescer(this);
+    job.updates->setProgressManager(job.progress);
+
+    const int id = job.id;
+    connect(job.updates, &UpdateCoalescer::linesReady, this, &RunQueue::linesReady);
+    connect(job.progress, &ProgressManager::progressChanged, this, [this, id](int value) {
+        if (Job *job = findJob(id)) {
+            job->percent = value;
+            emit jobChanged(id);
+            updateAggregate();
+        }
+    });
+    connect(job.progress, &ProgressManager::statusChanged, this, [this, id](const QString& text) {
+        if (Job *job = findJob(id)) {
+            job->status = text;
+            emit jobChanged(id);
+            updateAggregate();
+        }
+    });
+    connect(job.progress, &ProgressManager::etaChanged, this, [this, id](qint64 remainingMs) {
+        if (Job *job = findJob(id)) {
+            job->etaMs = remainingMs;
+            updateAggregate();
+        }
+    });
+    connect(job.progress, &ProgressManager::hostProgressChanged, this, &RunQueue::hostProgressChanged);
+    connect(job.progress, &ProgressManager::hostEtaChanged, this, &RunQueue::hostEtaChanged);
+
+    m_jobs.append(job);
+    emit jobChanged(id);
+    schedule();
+    return id;
+}
+
+void RunQueue::cancel(int jobId)
+{
+    Job *job = findJob(jobId);
+    if (!job) return;
+
+    if (job->state == State::Queued || job->state == State::RetryWaiting) {
+        job->state = State::Cancelled;
+        releaseStaging(*job, true);
+        emit outputReceived(QString("⛔ Запуск #%1 снят с очереди").arg(jobId));
+        emit jobChanged(jobId);
+        schedule();
+    } else if (job->state == State::Running && !job->cancelRequested) {
+        // Итог придет через finished от раннера
+        job->cancelRequested = true;
+        job->worker->stop();
+        emit jobChanged(jobId);
+    }
+}
+
+void RunQueue::cancelAll()
+{
+    for (int i = m_jobs.size() - 1; i >= 0; --i) {
+        cancel(m_jobs[i].id);
+    }
+}
+
+const RunQueue::Job *RunQueue::job(int jobId) const
+{
+    for (const Job& job : m_jobs) {
+        if (job.id == jobId) return &job;
+    }
+    return nullptr;
+}
+
+RunQueue::Job *RunQueue::findJob(int jobId)
+{
+    for (Job& job : m_jobs) {
+        if (job.id == jobId) return &job;
+    }
+    return nullptr;
+}
+
+RunQueue::Job *RunQueue::findJobByWorker(RunWorker *worker)
+{
+    for (Job& job : m_jobs) {
+        if (job.state == State::Running && job.worker == worker) return &job;
+    }
+    return nullptr;
+}
+
+int RunQueue::activeCount() const
+{
+    int count = 0;
+    for (const Job& job : m_jobs) {
+        if (isActive(job.state)) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+QString RunQueue::stateText(State state)
+{
+    switch (state) {
+        case State::Queued: return "в очереди";
+        case State::Running: return "выполняется";
+        case State::RetryWaiting: return "ожидает повтора";
+        case State::Succeeded: return "успешно";
+        case State::Failed: return "ошибка";
+        case State::Cancelled: return "отменен";
+    }
+    return QString();
+}
+
+QString RunQueue::describe(const Job& job) const
+{
+    QString text = QString("#%1  %2  хостов: %3  —  %4")
+                   .arg(job.id)
+                   .arg(job.label)
+                   .arg(job.settings.hosts.size())
+                   .arg(job.cancelRequested && job.state == State::Running ? "отменяется" : stateText(job.state));
+    if (!job.pending.isEmpty() || job.wave > 0) {
+        text += job.wave == 0 ? QString(" (канарейки, дальше %1)").arg(job.pending.size())
+                              : QString(" (волна %1, дальше %2)").arg(job.wave + 1).arg(job.pending.size());
+    }
+    if (job.attempt > 0) {
+        text += QString(" (повтор %1, хостов %2)").arg(job.attempt).arg(job.settings.hosts.size());
+    }
+    if (job.state == State::Running) {
+        text += QString(" %1%").arg(job.percent);
+        if (!job.status.isEmpty()) {
+            text += "  " + job.status;
+        }
+    } else if (!job.results.isEmpty()) {
+        int ok = 0;
+        int failed = 0;
+        int unreachable = 0;
+        int timedOut = 0;
+        int notStarted = 0;
+        for (const auto& result : job.results) {
+            switch (result.first) {
+                case AnsibleRunner::HostOutcome::Ok: ++ok; break;
+                case AnsibleRunner::HostOutcome::Failed: ++failed; break;
+                case AnsibleRunner::HostOutcome::Unreachable: ++unreachable; break;
+                case AnsibleRunner::HostOutcome::TimedOut: ++timedOut; break;
+                case AnsibleRunner::HostOutcome::NotStarted: ++notStarted; break;
+            }
+        }
+        text += QString("  ок %1, ошибок %2, недоступно %3").arg(ok).arg(failed).arg(unreachable);
+        if (timedOut > 0) {
+            text += QString(", по времени %1").arg(timedOut);
+        }
+        if (notStarted > 0) {
+            text += QString(", не запускалось %1").arg(notStarted);
+        }
+        if (job.tripped) {
+            text += "  ⛔ остановлен по порогу ошибок";
+        }
+    }
+    return text;
+}
+
+QList<HostConfig> RunQueue::failedHosts(const Job& job, bool includeNotStarted)
+{
+    QList<HostConfig> hosts;
+    for (const HostConfig& host : job.allHosts) {
+        auto it = job.results.constFind(host.endpoint());
+        if (it == job.results.constEnd() || it->first == AnsibleRunner::HostOutcome::Ok) continue;
+        if (it->first == AnsibleRunner::HostOutcome::NotStarted && !includeNotStarted) continue;
+        hosts.append(host);
+    }
+    return hosts;
+}
+
+bool RunQueue::breakerTripped(const Job& job, int *failPercent, int *deferred) const
+{
+    int attempted = 0;
+    int failed = 0;
+    int skipped = 0;
+    for (const auto& result : job.results) {
+        if (result.first == AnsibleRunner::HostOutcome::NotStarted) continue;
+        // Отложенные проверкой доступности хосты скрипт не выполняли - о
+        // скрипте они ничего не говорят и считаются отдельно
+        if (result.first == AnsibleRunner::HostOutcome::Unreachable
+            && result.second == QLatin1String(AnsibleRunner::preflightTask)) {
+            ++skipped;
+            continue;
+        }
+        ++attempted;
+        if (result.first != AnsibleRunner::HostOutcome::Ok) ++failed;
+    }
+    if (deferred) *deferred = skipped;
+    if (attempted == 0 || failed == 0) return false;
+
+    int percent = failed * 100 / attempted;
+    if (failPercent) *failPercent = percent;
+    // Ansible прервал оставшиеся партии внутри волны сам - итог тот же
+    bool ansibleAborted = false;
+    for (const HostConfig& host : job.settings.hosts) {
+        if (job.results.value(host.endpoint()).first == AnsibleRunner::HostOutcome::NotStarted) {
+            ansibleAborted = true;
+            break;
+        }
+    }
+    return percent > job.settings.maxFailPercent || (ansibleAborted && job.settings.maxFailPercent < 100);
+}
+
+QList<HostConfig> RunQueue::takeWave(Job& job) const
+{
+    // Волна - партия batchSize хостов (0 - все оставшиеся); внутри нее
+    // ansible-playbook дополнительно прерывает партии по max_fail_percentage
+    int size = job.settings.batchSize > 0 ? job.settings.batchSize : job.pending.size();
+    QList<HostConfig> wave = job.pending.mid(0, size);
+    job.pending = job.pending.mid(size);
+    return wave;
+}
+
+bool RunQueue::retryFailed(int jobId)
+{
+    Job *job = findJob(jobId);
+    if (!job || isActive(job->state)) return false;
+
+    const QList<HostConfig> hosts = failedHosts(*job, true);
+    if (hosts.isEmpty()) return false;
+
+    if (isIdle()) {
+        m_batchFailed = false;
+        for (Job& other : m_jobs) {
+            other.inBatch = false;
+        }
+    }
+    job->inBatch = true;
+    job->cancelRequested = false;
+    // Повтор по команде начинает счет автоматических попыток заново
+    job->autoRetries = 0;
+    job->tripped = false;
+    emit outputReceived(QString("🔁 Запуск #%1: повтор для хостов с ошибкой и не запускавшихся (%2)")
+                        .arg(jobId).arg(hosts.size()));
+    requeue(*job, hosts, 0);
+    schedule();
+    return true;
+}
+
+void RunQueue::requeue(Job& job, const QList<HostConfig>& hosts, int delayMs, bool retry)
+{
+    // Новая попытка - inventory только из этих хостов; завершенные хосты
+    // запуска освобождаются для других запусков, ждущие волны - нет
+    job.settings.hosts = hosts;
+    job.endpoints.clear();
+    for (const HostConfig& host : hosts + job.pending) {
+        job.endpoints.insert(host.endpoint());
+    }
+    if (retry) {
+        ++job.attempt;
+    } else {
+        ++job.wave;
+    }
+    job.percent = 0;
+    job.status.clear();
+    job.etaMs = -1;
+
+    const int id = job.id;
+    if (delayMs > 0) {
+        job.state = State::RetryWaiting;
+        QTimer::singleShot(delayMs, this, [this, id]() {
+            Job *job = findJob(id);
+            if (job && job->state == State::RetryWaiting) {
+                job->state = State::Queued;
+                emit jobChanged(id);
+                schedule();
+            }
+        });
+    } else {
+        job.state = State::Queued;
+    }
+    emit jobChanged(id);
+}
+
+qint64 RunQueue::backoffMs(int retry) const
+{
+    // Экспоненциальная пауза с разбросом ±20%, чтобы повторы разных
+    // запусков не били по хостам одновременно
+    qint64 delay = qMin<qint64>(kMaxRetryDelayMs, qint64(m_retryBaseDelayMs) << qMin(retry - 1, 16));
+    double jitter = 0.8 + 0.4 * QRandomGenerator::global()->generateDouble();
+    return qint64(delay * jitter);
+}
+
+void RunQueue::releaseStaging(const Job& job, bool keepScript)
+{
+    QDir dir(job.settings.stagingDir);
+    if (!keepScript) {
+        dir.removeRecursively();
+        return;
+    }
+    // inventory с паролями и патчи после запуска не нужны
+    const QString script = QFileInfo(job.settings.scriptPath).fileName();
+    const QStringList files = dir.entryList(QDir::Files);
+    for (const QString& name : files) {
+        if (name != script) {
+            dir.remove(name);
+        }
+    }
+}
+
+void RunQueue::stageScript(const QString& path)
+{
+    m_stager->stageScript(path);
+}
+
+void RunQueue::stageArchive(const QString& path)
+{
+    m_stager->stageArchive(path);
+}
+
+RunWorker *RunQueue::acquireWorker()
+{
+    if (!m_idleWorkers.isEmpty()) {
+        return m_idleWorkers.takeFirst();
+    }
+
+    // Свой поток, раннер и контроллер Ansible; исполнители переиспользуются
+    RunWorker *worker = new RunWorker(this);
+    connectWorker(worker);
+    if (!m_playbookPath.isEmpty()) {
+        worker->setPlaybookPath(m_playbookPath);
+    }
+    worker->setRecordedConcurrency(m_recordedConcurrency);
+    worker->setConnectionPool(m_connectionPool);
+    if (m_warm) {
+        worker->warmUpController();
+    }
+    m_workers.append(worker);
+    return worker;
+}
+
+void RunQueue::connectWorker(RunWorker *worker)
+{
+    connect(worker, &RunWorker::outputReceived, this, [this, worker](const QString& text) {
+        if (Job *job = findJobByWorker(worker)) {
+            job->updates->appendLine(tagLine(*job, text));
+        } else {
+            emit outputReceived(text);
+        }
+    });
+    connect(worker, &RunWorker::hostOutputReceived, this, &RunQueue::hostOutputReceived);
+    connect(worker, &RunWorker::errorOccurred, this, &RunQueue::errorOccurred);
+    connect(worker, &RunWorker::hostReachability, this, &RunQueue::hostReachability);
+    connect(worker, &RunWorker::hostResult, this,
+            [this, worker](const QString& endpoint, AnsibleRunner::HostOutcome outcome, const QString& task) {
+        // Итог новой попытки заменяет прежний итог хоста в записи запуска
+        if (Job *job = findJobByWorker(worker)) {
+            job->results.insert(endpoint, qMakePair(outcome, task));
+        }
+    });
+    connect(worker, &RunWorker::tuningRecorded, this, [this](int concurrency, int batchSize) {
+        // Подобранное значение получают и остальные исполнители
+        setRecordedConcurrency(concurrency);
+        emit tuningRecorded(concurrency, batchSize);
+    });
+    connect(worker, &RunWorker::finished, this, [this, worker](bool success, int) {
+        if (Job *job = findJobByWorker(worker)) {
+            finishJob(*job, success);
+        }
+    });
+}
+
+QString RunQueue::tagLine(const Job& job, const QString& text) const
+{
+    // При одном запуске вывод выглядит как раньше
+    int running = 0;
+    for (const Job& other : m_jobs) {
+        if (other.state == State::Running) ++running;
+    }
+    if (running < 2) {
+        return text;
+    }
+
+    // Префикс внутри разметки: журнал распознает span только с начала строки
+    QString tag = QString("[#%1] ").arg(job.id);
+    if (text.startsWith('<')) {
+        int end = text.indexOf('>');
+        if (end > 0) {
+            return text.left(end + 1) + tag + text.mid(end + 1);
+        }
+    }
+    return tag + text;
+}
+
+void RunQueue::startJob(Job& job)
+{
+    if (m_progressManager && !m_progressManager->isRunning()) {
+        m_progressManager->startProgress(100);
+    }
+
+    job.state = State::Running;
+    job.worker = acquireWorker();
+    job.updates->resetStats();
+    job.worker->setUpdateCoalescer(job.updates);
+    if (m_maxConcurrent > 1) {
+        job.updates->appendLine(tagLine(job, QString("▶️ Запуск #%1: хостов %2, каталог %3")
+                                        .arg(job.id).arg(job.settings.hosts.size())
+                                        .arg(QDir::toNativeSeparators(job.settings.stagingDir))));
+    }
+    job.worker->start(job.settings);
+    emit jobChanged(job.id);
+}
+
+void RunQueue::finishJob(Job& job, bool success)
+{
+    // Итог строкой после остального вывода запуска
+    job.updates->appendLine(tagLine(job, job.updates->summary()));
+    job.updates->flush();
+
+    job.worker->setUpdateCoalescer(nullptr);
+    m_idleWorkers.append(job.worker);
+    job.worker = nullptr;
+
+    const int id = job.id;
+    const QList<HostConfig> failed = failedHosts(job);
+    int failPercent = 0;
+    int deferred = 0;
+    if (job.cancelRequested) {
+        job.state = State::Cancelled;
+        emit outputReceived(QString("⛔ Запуск #%1 отменен").arg(id));
+    } else if ((!job.pending.isEmpty() || job.wave > 0 || job.settings.maxFailPercent < 100)
+               && breakerTripped(job, &failPercent, &deferred)) {
+        // Скрипт, видимо, сломан: повторы и следующие волны не запускаем
+        job.tripped = true;
+        job.state = State::Failed;
+        emit outputReceived(QString("⛔ Запуск #%1 остановлен: ошибок %2% при пороге %3%%4")
+                            .arg(id).arg(failPercent).arg(job.settings.maxFailPercent)
+                            .arg(deferred > 0 ? QString(", не учтено отложенных недоступных: %1").arg(deferred)
+                                              : QString()));
+    } else if (!failed.isEmpty() && job.autoRetries < m_maxRetries) {
+        ++job.autoRetries;
+        qint64 delay = backoffMs(job.autoRetries);
+        QStringList names;
+        for (const HostConfig& host : failed) {
+            names << host.endpoint();
+        }
+        emit outputReceived(QString("🔁 Запуск #%1: повтор %2 из %3 через %4 для хостов: %5")
+                            .arg(id).arg(job.autoRetries).arg(m_maxRetries)
+                            .arg(ProgressManager::formatDuration(delay), names.join(", ")));
+        requeue(job, failed, int(delay));
+        schedule();
+        return;
+    } else if (!job.pending.isEmpty()) {
+        // Канарейки (или прошлая волна) в пределах порога - следующая волна
+        QList<HostConfig> wave = takeWave(job);
+        emit outputReceived(QString("🐤 Запуск #%1: %2, следующая волна - хостов %3, дальше %4")
+                            .arg(id)
+                            .arg(failed.isEmpty() ? QString("ошибок нет") : QString("ошибок %1").arg(failed.size()))
+                            .arg(wave.size()).arg(job.pending.size()));
+        requeue(job, wave, 0, false);
+        schedule();
+        return;
+    } else {
+        bool allOk = true;
+        for (const HostConfig& host : job.allHosts) {
+            if (job.results.value(host.endpoint(), qMakePair(AnsibleRunner::HostOutcome::Failed, QString())).first
+                    != AnsibleRunner::HostOutcome::Ok) {
+                allOk = false;
+                break;
+            }
+        }
+        job.state = success && allOk ? State::Succeeded : State::Failed;
+    }
+
+    // Хосты, до которых запуск не дошел, - в запись как "не запускался"
+    QStringList untouched;
+    for (const HostConfig& host : job.pending) {
+        job.results.insert(host.endpoint(), qMakePair(AnsibleRunner::HostOutcome::NotStarted, QString()));
+    }
+    job.pending.clear();
+    for (const HostConfig& host : job.allHosts) {
+        if (job.results.value(host.endpoint()).first == AnsibleRunner::HostOutcome::NotStarted
+                && job.results.contains(host.endpoint())) {
+            untouched << host.endpoint();
+        }
+    }
+    if (!untouched.isEmpty()) {
+        emit outputReceived(QString("⏸ Запуск #%1: не запускались %2 хостов (продолжить - \"Повторить сбойные\"): %3")
+                            .arg(id).arg(untouched.size()).arg(untouched.join(", ")));
+    }
+
+    if (job.state != State::Succeeded) {
+        m_batchFailed = true;
+    }
+    releaseStaging(job, true);
+
+    emit jobChanged(id);
+    emit jobFinished(id, job.state == State::Succeeded);
+    schedule();
+}
+
+void RunQueue::schedule()
+{
+    int running = 0;
+    QSet<QString> busy;
+    for (const Job& job : m_jobs) {
+        if (job.state == State::Running) {
+            ++running;
+            busy.unite(job.endpoints);
+        } else if (job.state == State::RetryWaiting) {
+            // Хосты, ждущие повтора, не отдаются более поздним запускам
+            busy.unite(job.endpoints);
+        }
+    }
+
+    // Запуск ждет, пока его хосты заняты - в том числе более ранним запуском
+    // из очереди, чтобы на общих хостах сохранялся порядок постановки
+    for (Job& job : m_jobs) {
+        if (job.state != State::Queued) continue;
+        if (running < m_maxConcurrent && !busy.intersects(job.endpoints)) {
+            startJob(job);
+            ++running;
+        }
+        busy.unite(job.endpoints);
+    }
+
+    updateAggregate();
+    if (isIdle()) {
+        if (m_progressManager && m_progressManager->isRunning()) {
+            m_progressManager->stopProgress(!m_batchFailed);
+        }
+        emit idle();
+    }
+}
+
+void RunQueue::updateAggregate()
+{
+    if (!m_progressManager || !m_progressManager->isRunning()) return;
+
+    // Серия - запуски с момента, когда очередь была пуста
+    int total = 0;
+    int percentSum = 0;
+    int running = 0;
+    int queued = 0;
+    int done = 0;
+    qint64 eta = -1;
+    const Job *single = nullptr;
+    for (const Job& job : m_jobs) {
+        if (!job.inBatch) continue;
+        ++total;
+        switch (job.state) {
+            case State::Running:
+                ++running;
+                single = &job;
+                percentSum += job.percent;
+                eta = qMax(eta, job.etaMs);
+                break;
+            case State::Queued:
+            case State::RetryWaiting:
+                ++queued;
+                break;
+            default:
+                ++done;
+                percentSum += 100;
+                break;
+        }
+    }
+    if (total == 0) return;
+
+    QString status = running == 1 && queued == 0 && single
+        ? single->status
+        : QString("Запусков: выполняется %1, в очереди %2, завершено %3").arg(running).arg(queued).arg(done);
+    m_progressManager->updateProgress(percentSum / total, status);
+    // С ожидающими в очереди точной оценки нет - экстраполяция по прошедшему времени
+    m_progressManager->setEta(queued > 0 ? -1 : eta);
+}
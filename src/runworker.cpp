@@ -0,0 +1,329 @@
+#include "runworker.h"
+#include <QFileInfo>
+#include <climits>
+
+namespace {
+// Период, с которым GUI забирает события, мс
+const int kDrainInterval = 30;
+// Сколько событий обрабатывается за один тик, чтобы окно оставалось отзывчивым
+const int kDrainBudget = 4000;
+}
+
+RunWorker::RunWorker(QObject *parent)
+    : QObject(parent)
+    , m_runner(new AnsibleRunner())
+    , m_workerProgress(new ProgressManager())
+    , m_updates(nullptr)
+    , m_shuttingDown(false)
+    , m_writerWaiting(false)
+{
+    m_thread.setObjectName("RunWorker");
+    m_runner->setProgressManager(m_workerProgress);
+    connectProducer();
+
+    // Объекты созданы здесь, но дальше живут (и создают дочерние процессы) в рабочем потоке
+    m_runner->moveToThread(&m_thread);
+    m_workerProgress->moveToThread(&m_thread);
+    m_thread.start();
+
+    m_drainTimer.setInterval(kDrainInterval);
+    connect(&m_drainTimer, &QTimer::timeout, this, &RunWorker::drainEvents);
+    m_drainTimer.start();
+}
+
+RunWorker::~RunWorker()
+{
+    // Писатель больше не ждет места в очереди - иначе блокирующий вызов ниже зависнет
+    m_shuttingDown = true;
+    m_drainTimer.stop();
+    {
+        QMutexLocker locker(&m_spaceMutex);
+        m_spaceFreed.wakeAll();
+    }
+
+    AnsibleRunner *runner = m_runner;
+    ProgressManager *workerProgress = m_workerProgress;
+    QMetaObject::invokeMethod(runner, [runner, workerProgress]() {
+        runner->stop();
+        delete runner;
+        delete workerProgress;
+    }, Qt::BlockingQueuedConnection);
+
+    m_thread.quit();
+    m_thread.wait();
+}
+
+void RunWorker::setUpdateCoalescer(UpdateCoalescer *updates)
+{
+    m_updates = updates;
+}
+
+void RunWorker::connectProducer()
+{
+    // Все сигналы ниже испускаются в рабочем потоке, поэтому DirectConnection:
+    // обработчик только кладет событие в очередь
+    connect(m_runner, &AnsibleRunner::outputReceived, m_runner, [this](const QString& text) {
+        post(RunEvent::Type::Output, text);
+    }, Qt::DirectConnection);
+    connect(m_runner, &AnsibleRunner::hostOutputReceived, m_runner,
+            [this](const QString& endpoint, const QString& task, const QString& text) {
+        RunEvent event;
+        event.type = RunEvent::Type::HostOutput;
+        event.host = endpoint;
+        event.task = task;
+        event.text = text;
+        post(event);
+    }, Qt::DirectConnection);
+    connect(m_runner, &AnsibleRunner::errorOccurred, m_runner, [this](const QString& text) {
+        post(RunEvent::Type::Error, text);
+    }, Qt::DirectConnection);
+    connect(m_runner, &AnsibleRunner::finished, m_runner, [this](bool success, int exitCode) {
+        post(RunEvent::Type::Finished, QString(), exitCode, success);
+    }, Qt::DirectConnection);
+    connect(m_runner, &AnsibleRunner::tuningRecorded, m_runner, [this](int concurrency, int batchSize) {
+        RunEvent event;
+        event.type = RunEvent::Type::Tuning;
+        event.value = concurrency;
+        event.extra = batchSize;
+        post(event);
+    }, Qt::DirectConnection);
+    connect(m_runner, &AnsibleRunner::hostResult, m_runner,
+            [this](const QString& endpoint, AnsibleRunner::HostOutcome outcome, const QString& task) {
+        RunEvent event;
+        event.type = RunEvent::Type::HostResult;
+        event.host = endpoint;
+        event.task = task;
+        event.value = int(outcome);
+        post(event);
+    }, Qt::DirectConnection);
+    connect(m_runner, &AnsibleRunner::hostReachability, m_runner,
+            [this](const QString& endpoint, bool reachable, qint64 latencyMs) {
+        RunEvent event;
+        event.type = RunEvent::Type::Reachability;
+        event.host = endpoint;
+        event.success = reachable;
+        event.value = int(latencyMs);
+        post(event);
+    }, Qt::DirectConnection);
+
+    connect(m_workerProgress, &ProgressManager::progressChanged, m_workerProgress, [this](int value) {
+        post(RunEvent::Type::Progress, QString(), value);
+    }, Qt::DirectConnection);
+    connect(m_workerProgress, &ProgressManager::statusChanged, m_workerProgress, [this](const QString& text) {
+        post(RunEvent::Type::Status, text);
+    }, Qt::DirectConnection);
+    connect(m_workerProgress, &ProgressManager::runningStateChanged, m_workerProgress, [this](bool running) {
+        // Остановку передает progressCompleted вместе с итогом
+        if (running) {
+            post(RunEvent::Type::RunningChanged, QString(), 0, true);
+        }
+    }, Qt::DirectConnection);
+    connect(m_workerProgress, &ProgressManager::progressCompleted, m_workerProgress, [this](bool success) {
+        post(RunEvent::Type::ProgressFinished, QString(), 0, success);
+    }, Qt::DirectConnection);
+    connect(m_workerProgress, &ProgressManager::hostEtaChanged, m_workerProgress,
+            [this](const QString& endpoint, qint64 remainingMs, bool slow) {
+        RunEvent event;
+        event.type = RunEvent::Type::HostEta;
+        event.host = endpoint;
+        event.value = int(qMin<qint64>(remainingMs, INT_MAX));
+        event.success = slow;
+        post(event);
+    }, Qt::DirectConnection);
+    connect(m_workerProgress, &ProgressManager::etaChanged, m_workerProgress, [this](qint64 remainingMs) {
+        post(RunEvent::Type::Eta, QString(), int(qMin<qint64>(remainingMs, INT_MAX)));
+    }, Qt::DirectConnection);
+    connect(m_workerProgress, &ProgressManager::hostProgressChanged, m_workerProgress,
+            [this](const QString& endpoint, int percent) {
+        RunEvent event;
+        event.type = RunEvent::Type::HostProgress;
+        event.host = endpoint;
+        event.value = percent;
+        post(event);
+    }, Qt::DirectConnection);
+}
+
+void RunWorker::post(RunEvent event)
+{
+    if (m_queue.tryPush(std::move(event))) return;
+
+    // Очередь заполнена: GUI не успевает - рабочий поток ждет, пока
+    // drainEvents освободит место. Флаг ставится до повторной попытки,
+    // поэтому пробуждение после нее не теряется
+    QMutexLocker locker(&m_spaceMutex);
+    m_writerWaiting = true;
+    while (!m_queue.tryPush(std::move(event))) {
+        if (m_shuttingDown) break;
+        m_spaceFreed.wait(&m_spaceMutex);
+    }
+    m_writerWaiting = false;
+}
+
+void RunWorker::post(RunEvent::Type type, const QString& text, int value, bool success)
+{
+    RunEvent event;
+    event.type = type;
+    event.text = text;
+    event.value = value;
+    event.success = success;
+    post(event);
+}
+
+void RunWorker::setPlaybookPath(const QString& path)
+{
+    AnsibleRunner *runner = m_runner;
+    QMetaObject::invokeMethod(runner, [runner, path]() {
+        runner->setPlaybookPath(path);
+    }, Qt::QueuedConnection);
+}
+
+void RunWorker::setRecordedConcurrency(int concurrency)
+{
+    AnsibleRunner *runner = m_runner;
+    QMetaObject::invokeMethod(runner, [runner, concurrency]() {
+        runner->setRecordedConcurrency(concurrency);
+    }, Qt::QueuedConnection);
+}
+
+void RunWorker::setConnectionPool(SshConnectionPool *pool)
+{
+    AnsibleRunner *runner = m_runner;
+    QMetaObject::invokeMethod(runner, [runner, pool]() {
+        runner->setConnectionPool(pool);
+    }, Qt::QueuedConnection);
+}
+
+void RunWorker::warmUpController()
+{
+    AnsibleRunner *runner = m_runner;
+    QMetaObject::invokeMethod(runner, [runner]() {
+        runner->warmUpController();
+    }, Qt::QueuedConnection);
+}
+
+void RunWorker::start(const RunSettings& settings)
+{
+    AnsibleRunner *runner = m_runner;
+    QMetaObject::invokeMethod(runner, [runner, settings]() {
+        if (!settings.stagingDir.isEmpty()) {
+            runner->setStagingDir(settings.stagingDir);
+        }
+        runner->setHosts(settings.hosts);
+        runner->setScriptPath(settings.scriptPath);
+        runner->setArchivePath(settings.archivePath);
+        runner->setBatchSize(settings.batchSize);
+        runner->setForks(settings.forks);
+        runner->setFusedMode(settings.fusedMode);
+        runner->setStreamArchive(settings.streamArchive);
+        runner->setLiveOutput(settings.liveOutput);
+        runner->setFanoutDegree(settings.fanoutDegree);
+        runner->setMaxFailPercent(settings.maxFailPercent);
+        runner->setTimeouts(settings.taskTimeoutSec, settings.hostTimeoutSec);
+        runner->setPreflightTimeout(settings.preflightTimeoutMs);
+        runner->setOutputPatterns(settings.outputPatterns);
+        runner->setEngine(settings.engine);
+        runner->executePlaybook();
+    }, Qt::QueuedConnection);
+}
+
+void RunWorker::stop()
+{
+    AnsibleRunner *runner = m_runner;
+    QMetaObject::invokeMethod(runner, [runner]() {
+        runner->stop();
+    }, Qt::QueuedConnection);
+}
+
+void RunWorker::stageScript(const QString& path)
+{
+    AnsibleRunner *runner = m_runner;
+    QMetaObject::invokeMethod(runner, [this, runner, path]() {
+        QString archivePath;
+        bool success = runner->stageScript(path, &archivePath);
+
+        RunEvent event;
+        event.type = RunEvent::Type::ScriptStaged;
+        event.success = success;
+        event.text = path;
+        event.host = archivePath;
+        post(event);
+    }, Qt::QueuedConnection);
+}
+
+void RunWorker::stageArchive(const QString& path)
+{
+    AnsibleRunner *runner = m_runner;
+    QMetaObject::invokeMethod(runner, [this, path]() {
+        bool success = QFileInfo(path).isFile();
+        post(RunEvent::Type::ArchiveStaged, path, 0, success);
+    }, Qt::QueuedConnection);
+}
+
+void RunWorker::drainEvents()
+{
+    RunEvent event;
+    int drained = 0;
+    for (; drained < kDrainBudget && m_queue.tryPop(event); ++drained) {
+        dispatch(event);
+    }
+    if (drained > 0 && m_writerWaiting) {
+        QMutexLocker locker(&m_spaceMutex);
+        m_spaceFreed.wakeAll();
+    }
+}
+
+void RunWorker::dispatch(const RunEvent& event)
+{
+    switch (event.type) {
+        case RunEvent::Type::Output:
+            emit outputReceived(event.text);
+            break;
+        case RunEvent::Type::HostOutput:
+            emit hostOutputReceived(event.host, event.task, event.text);
+            break;
+        case RunEvent::Type::Error:
+            emit errorOccurred(event.text);
+            break;
+        case RunEvent::Type::Status:
+            if (m_updates) m_updates->setStatusText(event.text);
+            break;
+        case RunEvent::Type::Progress:
+            if (m_updates) m_updates->setProgress(event.value);
+            break;
+        case RunEvent::Type::HostProgress:
+            if (m_updates) m_updates->setHostProgress(event.host, event.value);
+            break;
+        case RunEvent::Type::HostEta:
+            if (m_updates) m_updates->setHostEta(event.host, event.value, event.success);
+            break;
+        case RunEvent::Type::Eta:
+            if (m_updates) m_updates->setEta(event.value);
+            break;
+        case RunEvent::Type::RunningChanged:
+            if (m_updates) m_updates->startProgress();
+            break;
+        case RunEvent::Type::ProgressFinished:
+            if (m_updates) m_updates->stopProgress(event.success);
+            break;
+        case RunEvent::Type::Reachability:
+            emit hostReachability(event.host, event.success, event.value);
+            break;
+        case RunEvent::Type::Tuning:
+            emit tuningRecorded(event.value, event.extra);
+            break;
+        case RunEvent::Type::HostResult:
+            emit hostResult(event.host, AnsibleRunner::HostOutcome(event.value), event.task);
+            break;
+        case RunEvent::Type::ScriptStaged:
+            emit scriptStaged(event.success, event.text, event.host);
+            break;
+        case RunEvent::Type::ArchiveStaged:
+            emit archiveStaged(event.success, event.text);
+            break;
+        case RunEvent::Type::Finished:
+            emit finished(event.success, event.value);
+            break;
+        default:
+            break;
+    }
+}
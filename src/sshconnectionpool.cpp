@@ -0,0 +1,243 @@
+#include "sshconnectionpool.h"
+#include "sshexecutor.h"
+#include "processtree.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QProcessEnvironment>
+#include <QDebug>
+
+namespace {
+const int kHealthIntervalMs = 15000;
+const char *kControlPathTemplate = "/tmp/cpustat-cm-%r@%h:%p";
+}
+
+SshConnectionPool::SshConnectionPool(QObject *parent)
+    : QObject(parent)
+    , m_healthTimer(new QTimer(this))
+    , m_checkProcess(new QProcess(this))
+    , m_idleTimeoutSec(600)
+{
+    m_healthTimer->setInterval(kHealthIntervalMs);
+    connect(m_healthTimer, &QTimer::timeout, this, &SshConnectionPool::onHealthTimer);
+    connect(m_checkProcess, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+            this, &SshConnectionPool::onCheckFinished);
+}
+
+SshConnectionPool::~SshConnectionPool()
+{
+    closeAll();
+}
+
+void SshConnectionPool::setIdleTimeout(int seconds)
+{
+    m_idleTimeoutSec = qMax(30, seconds);
+}
+
+QString SshConnectionPool::controlPath(const HostConfig& host)
+{
+    return QString("/tmp/cpustat-cm-%1@%2:%3").arg(host.sshUser, host.address).arg(host.sshPort);
+}
+
+QStringList SshConnectionPool::controlOptions()
+{
+    QStringList options;
+    options << "-o" << "ControlMaster=auto";
+    options << "-o" << QString("ControlPath=%1").arg(kControlPathTemplate);
+    options << "-o" << "ControlPersist=600";
+    return options;
+}
+
+QString SshConnectionPool::stateText(State state)
+{
+    switch (state) {
+        case State::Connecting:
+            return "⏳ подключение";
+        case State::Warm:
+            return "🔥 подключен";
+        case State::Failed:
+            return "⚠️ нет подключения";
+        default:
+            return "❄️ не подключен";
+    }
+}
+
+void SshConnectionPool::warmUp(const QList<HostConfig>& hosts)
+{
+    for (const HostConfig& host : hosts) {
+        Master& master = m_masters[host.endpoint()];
+        master.host = host;
+        master.lastUsed.start();
+
+        if (master.state == State::Cold || master.state == State::Failed) {
+            startMaster(master);
+        }
+    }
+
+    if (!m_healthTimer->isActive()) {
+        m_healthTimer->start();
+    }
+    // Первую проверку делаем вскоре после запуска мастеров
+    QTimer::singleShot(2000, this, &SshConnectionPool::onHealthTimer);
+}
+
+void SshConnectionPool::touch(const QString& endpoint)
+{
+    auto it = m_masters.find(endpoint);
+    if (it != m_masters.end()) {
+        it->lastUsed.restart();
+    }
+}
+
+SshConnectionPool::State SshConnectionPool::state(const QString& endpoint) const
+{
+    auto it = m_masters.constFind(endpoint);
+    return it == m_masters.constEnd() ? State::Cold : it->state;
+}
+
+void SshConnectionPool::closeAll()
+{
+    m_healthTimer->stop();
+    for (Master& master : m_masters) {
+        closeMaster(master);
+    }
+    m_masters.clear();
+}
+
+void SshConnectionPool::startMaster(Master& master)
+{
+    if (master.process) {
+        closeMaster(master);
+    }
+
+    const HostConfig& host = master.host;
+    QProcess *process = new QProcess(this);
+
+    if (!host.sshPass.isEmpty()) {
+        QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+        env.insert("SSHPASS", host.sshPass);
+        QString wslEnv = env.value("WSLENV");
+        env.insert("WSLENV", wslEnv.isEmpty() ? "SSHPASS/u" : wslEnv + ":SSHPASS/u");
+        process->setProcessEnvironment(env);
+    }
+
+    // Мастер держим на переднем плане (-N без -f): пока жив процесс wsl,
+    // жив и дистрибутив, и сокет подключения. Своя группа процессов в WSL:
+    // закрытие снимает сам ssh -M, а не только wsl.exe (processtree.h)
+    QStringList args;
+    if (!host.sshPass.isEmpty()) {
+        args << "sshpass" << "-e";
+    }
+    args << "ssh" << "-M" << "-N";
+    args << "-o" << QString("ControlPath=%1").arg(controlPath(host));
+    args << "-o" << "ControlPersist=no";
+    args << "-o" << "ServerAliveInterval=15";
+    args << "-o" << "StrictHostKeyChecking=no";
+    args << "-o" << "UserKnownHostsFile=/dev/null";
+    args << "-o" << "LogLevel=ERROR";
+    args << "-o" << "ConnectTimeout=10";
+    args << "-p" << QString::number(host.sshPort);
+    args << host.sshUser + "@" + host.address;
+
+    QString endpoint = host.endpoint();
+    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+            this, [this, endpoint, process](int exitCode, QProcess::ExitStatus) {
+        auto it = m_masters.find(endpoint);
+        if (it == m_masters.end() || it->process != process) return;
+
+        qDebug() << "Мастер-подключение к" << endpoint << "завершилось, код" << exitCode;
+        ProcessTree::release(it->pidFile);
+        it->process = nullptr;
+        process->deleteLater();
+        setState(*it, exitCode == 0 ? State::Cold : State::Failed);
+    });
+
+    QString safeEndpoint = endpoint;
+    safeEndpoint.replace(':', '_');
+    master.pidFile = QDir::temp().filePath(QString("cpustat-cm-%1-%2.pid")
+                                           .arg(QCoreApplication::applicationPid()).arg(safeEndpoint));
+    master.process = process;
+    setState(master, State::Connecting);
+    process->start("wsl", ProcessTree::wrap(master.pidFile, args));
+}
+
+void SshConnectionPool::closeMaster(Master& master)
+{
+    if (!master.process) return;
+
+    QProcess *process = master.process;
+    master.process = nullptr;
+    process->disconnect(this);
+    // Без ожидания: ssh -M в WSL останавливается в фоне (сокет удаляет сам ssh),
+    // объект процесса удаляется, когда wsl.exe выйдет
+    ProcessTree::terminate(process, master.pidFile);
+    if (process->state() == QProcess::NotRunning) {
+        process->deleteLater();
+    } else {
+        connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+                process, &QObject::deleteLater);
+    }
+    setState(master, State::Cold);
+}
+
+void SshConnectionPool::setState(Master& master, State state)
+{
+    if (master.state == state) return;
+    master.state = state;
+    emit hostStateChanged(master.host.endpoint(), state);
+}
+
+void SshConnectionPool::onHealthTimer()
+{
+    // Закрываем подключения, которые давно не использовались
+    for (Master& master : m_masters) {
+        if (master.process && master.lastUsed.elapsed() > m_idleTimeoutSec * 1000LL) {
+            qDebug() << "Закрытие неиспользуемого подключения:" << master.host.endpoint();
+            closeMaster(master);
+        }
+    }
+
+    if (m_checkProcess->state() != QProcess::NotRunning) return;
+
+    // Одна проверка на все мастера: ssh -O check по каждому сокету
+    QStringList checks;
+    for (const Master& master : m_masters) {
+        if (!master.process) continue;
+        QString path = SshExecutor::shellQuote(controlPath(master.host));
+        checks << QString("if ssh -o ControlPath=%1 -O check cpustat 2>/dev/null; then echo OK %2; else echo DEAD %2; fi")
+                  .arg(path, master.host.endpoint());
+    }
+
+    if (checks.isEmpty()) {
+        if (m_masters.isEmpty()) {
+            m_healthTimer->stop();
+        }
+        return;
+    }
+
+    QStringList args;
+    args << "--" << "bash" << "-c" << checks.join("; ");
+    m_checkProcess->start("wsl", args);
+}
+
+void SshConnectionPool::onCheckFinished(int exitCode, QProcess::ExitStatus status)
+{
+    Q_UNUSED(exitCode)
+    Q_UNUSED(status)
+
+    const QList<QByteArray> lines = m_checkProcess->readAllStandardOutput().split('\n');
+    for (const QByteArray& rawLine : lines) {
+        QString line = QString::fromUtf8(rawLine).trimmed();
+        int space = line.indexOf(' ');
+        if (space < 0) continue;
+
+        auto it = m_masters.find(line.mid(space + 1));
+        if (it == m_masters.end() || !it->process) continue;
+
+        if (line.startsWith("OK")) {
+            setState(*it, State::Warm);
+        } else if (it->state == State::Warm) {
+            // Мастер был жив, но перестал отвечать - поднимаем заново
+            startMaster(*it);
+        }
+    }
+}
@@ -0,0 +1,681 @@
+#include "sshexecutor.h"
+#include "remotebundle.h"
+#include "artifactcache.h"
+#include "deltatransfer.h"
+#include "fanouttree.h"
+#include "sshconnectionpool.h"
+#include "processtree.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QProcessEnvironment>
+#include <QDebug>
+
+namespace {
+// Размер порции и предел буфера записи при передаче артефактов:
+// в памяти одновременно находится не больше ~1 МБ файла на хост
+const qint64 kStreamChunkSize = 256 * 1024;
+const qint64 kStreamMaxBuffered = 1024 * 1024;
+}
+
+SshExecutor::SshExecutor(QObject *parent)
+    : QObject(parent)
+    , m_maxParallel(20)
+    , m_activeCount(0)
+    , m_completedSteps(0)
+    , m_isRunning(false)
+    , m_fusedMode(false)
+    , m_streamArchive(false)
+    , m_fanoutDegree(0)
+    , m_stepTimeoutSec(0)
+    , m_hostTimeoutSec(0)
+    , m_watchdog(new QTimer(this))
+{
+    m_watchdog->setInterval(1000);
+    connect(m_watchdog, &QTimer::timeout, this, &SshExecutor::checkTimeouts);
+}
+
+SshExecutor::~SshExecutor()
+{
+    stop();
+}
+
+void SshExecutor::setHosts(const QList<HostConfig>& hosts)
+{
+    m_hosts = hosts;
+}
+
+void SshExecutor::setScriptPath(const QString& path)
+{
+    m_scriptPath = path;
+}
+
+void SshExecutor::setArchivePath(const QString& path)
+{
+    m_archivePath = path;
+}
+
+void SshExecutor::setStagingDir(const QString& dir)
+{
+    m_stagingDir = dir;
+}
+
+void SshExecutor::setMaxParallel(int count)
+{
+    m_maxParallel = qMax(1, count);
+
+    // При увеличении лимита во время выполнения сразу запускаем ожидающие хосты
+    if (m_isRunning) {
+        scheduleJobs();
+    }
+}
+
+void SshExecutor::setFusedMode(bool enabled)
+{
+    m_fusedMode = enabled;
+}
+
+void SshExecutor::setStreamArchive(bool enabled)
+{
+    m_streamArchive = enabled;
+}
+
+void SshExecutor::setFanoutDegree(int degree)
+{
+    m_fanoutDegree = qMax(0, degree);
+}
+
+void SshExecutor::setTimeouts(int stepTimeoutSec, int hostTimeoutSec)
+{
+    m_stepTimeoutSec = qMax(0, stepTimeoutSec);
+    m_hostTimeoutSec = qMax(0, hostTimeoutSec);
+}
+
+bool SshExecutor::isStreaming() const
+{
+    return m_streamArchive && !m_archivePath.isEmpty() && RemoteBundle::canStream(m_archivePath);
+}
+
+int SshExecutor::stepsPerHost() const
+{
+    int steps = m_archivePath.isEmpty() ? 2 : 3;
+    return m_fusedMode ? steps - 1 : steps;
+}
+
+SshExecutor::Step SshExecutor::firstStep() const
+{
+    if (!m_fusedMode) return CopyScript;
+    return m_archivePath.isEmpty() ? Execute : CopyArchive;
+}
+
+void SshExecutor::start()
+{
+    if (m_isRunning) return;
+
+    if (m_fusedMode) {
+        // Скрипт встраивается в сценарий - отдельное копирование не нужно
+        QFile scriptFile(m_scriptPath);
+        if (!scriptFile.open(QIODevice::ReadOnly)) {
+            emit outputReceived("❌ Не удалось прочитать скрипт: " + m_scriptPath);
+            emit finished(false);
+            return;
+        }
+        m_scriptContent = scriptFile.readAll();
+    } else {
+        m_scriptArtifact = ArtifactCache::describe(m_scriptPath);
+    }
+
+    // Хеши артефактов: на хост передаются только blob, которых нет в его кэше
+    m_archiveArtifact = ArtifactCache::Artifact();
+    m_archiveDelta = ArtifactCache::Delta();
+    if (!m_archivePath.isEmpty()) {
+        m_archiveArtifact = ArtifactCache::describe(m_archivePath);
+
+        // Хостам с прошлой версией архива отправим только патч
+        QString summary;
+        m_archiveDelta = DeltaTransfer::prepare(m_archiveArtifact, m_stagingDir, &summary);
+        if (!summary.isEmpty()) {
+            emit outputReceived(summary);
+        }
+    }
+    if ((!m_fusedMode && !m_scriptArtifact.isValid())
+            || (!m_archivePath.isEmpty() && !m_archiveArtifact.isValid())) {
+        emit outputReceived("❌ Не удалось прочитать скрипт или архив для передачи");
+        emit finished(false);
+        return;
+    }
+
+    m_jobs.clear();
+    for (const HostConfig& host : m_hosts) {
+        HostJob job;
+        job.host = host;
+        job.step = firstStep();
+        job.pidFile = QDir(m_stagingDir).filePath(QString("ssh_%1.pid").arg(m_jobs.size() + 1));
+        m_jobs.append(job);
+    }
+
+    FanoutTree tree(m_jobs.size(), m_fanoutDegree);
+    if (!m_archivePath.isEmpty() && tree.isEnabled()) {
+        // Хост с паролем получает архив напрямую: его пароль не передается
+        // на родителя, ретрансляция возможна только по ключу из агента
+        int direct = 0;
+        for (int i = 0; i < m_jobs.size(); ++i) {
+            if (tree.parent(i) >= 0 && !m_jobs[i].host.sshPass.isEmpty()) {
+                ++direct;
+                continue;
+            }
+            m_jobs[i].parent = tree.parent(i);
+        }
+        emit outputReceived(QString("🌳 Раздача архива деревом: сидов %1, ярусов ретрансляции %2")
+                            .arg(m_fanoutDegree).arg(tree.depth()));
+        if (direct > 0) {
+            emit outputReceived(QString("🔑 Хостов с паролем вне дерева: %1 - архив им загружается напрямую")
+                                .arg(direct));
+        }
+    }
+
+    m_activeCount = 0;
+    m_completedSteps = 0;
+    m_isRunning = true;
+
+    emit outputReceived(QString("🔌 Прямое SSH-выполнение: хостов %1, параллельно до %2")
+                        .arg(m_jobs.size()).arg(m_maxParallel));
+    if (m_stepTimeoutSec > 0 || m_hostTimeoutSec > 0) {
+        emit outputReceived(QString("⏱ Пределы времени: шаг %1, хост %2")
+                            .arg(m_stepTimeoutSec > 0 ? QString("%1 с").arg(m_stepTimeoutSec) : QString("без предела"),
+                                 m_hostTimeoutSec > 0 ? QString("%1 с").arg(m_hostTimeoutSec) : QString("без предела")));
+    }
+
+    if (m_jobs.isEmpty()) {
+        m_isRunning = false;
+        emit finished(false);
+        return;
+    }
+
+    if (m_stepTimeoutSec > 0 || m_hostTimeoutSec > 0) {
+        m_watchdog->start();
+    }
+    scheduleJobs();
+}
+
+void SshExecutor::stop()
+{
+    if (!m_isRunning) return;
+
+    m_isRunning = false;
+    m_watchdog->stop();
+    for (HostJob& job : m_jobs) {
+        closeSource(job);
+        if (job.process) {
+            abandonProcess(job);
+        }
+    }
+    m_activeCount = 0;
+}
+
+void SshExecutor::abandonProcess(HostJob& job)
+{
+    QProcess *process = job.process;
+    job.process = nullptr;
+    process->disconnect(this);
+    // Без ожидания: дерево в WSL (sshpass, ssh) останавливается в фоне,
+    // объект процесса удаляется, когда wsl.exe выйдет
+    ProcessTree::terminate(process, job.pidFile);
+    if (process->state() == QProcess::NotRunning) {
+        process->deleteLater();
+    } else {
+        connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+                process, &QObject::deleteLater);
+    }
+}
+
+void SshExecutor::checkTimeouts()
+{
+    if (!m_isRunning) return;
+
+    for (int i = 0; i < m_jobs.size(); ++i) {
+        HostJob& job = m_jobs[i];
+        if (!job.process || job.finished) continue;
+
+        bool stepExpired = m_stepTimeoutSec > 0 && job.stepTimer.elapsed() > m_stepTimeoutSec * 1000LL;
+        bool hostExpired = m_hostTimeoutSec > 0 && job.hostTimer.elapsed() > m_hostTimeoutSec * 1000LL;
+        if (!stepExpired && !hostExpired) continue;
+
+        emit outputReceived(QString("⏱ [%1] Превышен предел времени %2 (%3 с) на шаге: %4, хост остановлен")
+                            .arg(job.host.endpoint(), hostExpired ? QString("хоста") : QString("шага"))
+                            .arg(hostExpired ? m_hostTimeoutSec : m_stepTimeoutSec)
+                            .arg(stepName(job.step)));
+        job.timedOut = true;
+        emit hostTimedOut(job.host.endpoint(), stepName(job.step));
+
+        closeSource(job);
+        abandonProcess(job);
+        --m_activeCount;
+        finishStep(job, false);
+        if (!m_isRunning) return;
+    }
+}
+
+void SshExecutor::scheduleJobs()
+{
+    for (HostJob& job : m_jobs) {
+        if (m_activeCount >= m_maxParallel) break;
+        if (job.finished || job.process || isWaitingForParent(job)) continue;
+
+        startStep(job);
+    }
+}
+
+bool SshExecutor::isWaitingForParent(const HostJob& job) const
+{
+    if (job.step != CopyArchive || job.parent < 0 || job.relayFailed) return false;
+
+    // Родитель, не получивший архив, уже не перешлет его - тогда грузим напрямую
+    const HostJob& parent = m_jobs[job.parent];
+    return !parent.archiveReady && !parent.finished;
+}
+
+void SshExecutor::startStep(HostJob& job)
+{
+    QProcess *process = new QProcess(this);
+    process->setProcessChannelMode(QProcess::MergedChannels);
+
+    job.relay = job.step == CopyArchive && job.parent >= 0 && !job.relayFailed
+                && m_jobs[job.parent].archiveReady;
+    // При ретрансляции подключаемся к родителю, а не к самому хосту
+    const HostConfig& connectHost = job.relay ? m_jobs[job.parent].host : job.host;
+
+    if (!connectHost.sshPass.isEmpty()) {
+        // Пароль передаем через окружение, чтобы он не попадал в командную строку
+        QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+        env.insert("SSHPASS", connectHost.sshPass);
+        QString wslEnv = env.value("WSLENV");
+        env.insert("WSLENV", wslEnv.isEmpty() ? "SSHPASS/u" : wslEnv + ":SSHPASS/u");
+        process->setProcessEnvironment(env);
+    }
+
+    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+            this, &SshExecutor::onHostProcessFinished);
+    connect(process, &QProcess::errorOccurred, this, &SshExecutor::onHostProcessErrorOccurred);
+    connect(process, &QProcess::readyReadStandardOutput, this, &SshExecutor::onHostProcessOutput);
+
+    job.process = process;
+    job.output.clear();
+    job.remoteStarted = false;
+    job.markerSeen = false;
+    job.stepTimer.start();
+    if (!job.hostTimer.isValid()) {
+        job.hostTimer.start();
+    }
+    ++m_activeCount;
+
+    emit hostStepStarted(job.host.endpoint(), stepName(job.step));
+
+    // Своя группа процессов в WSL: при остановке или по пределу времени
+    // снимается и ssh, а не только wsl.exe
+    process->start("wsl", ProcessTree::wrap(job.pidFile, buildStepArguments(job)));
+
+    if (job.step == Execute) {
+        process->write(buildRemoteCommand(job.host).toUtf8());
+        process->closeWriteChannel();
+    } else if (job.relay) {
+        // Данные потомку родитель берет из своего кэша
+        process->closeWriteChannel();
+    } else {
+        // Данные отправляем только после ответа хоста "@@CAS need"
+        connect(process, &QProcess::bytesWritten, this, [this, process]() {
+            HostJob *copyJob = findJob(process);
+            if (copyJob) {
+                feedSource(*copyJob);
+            }
+        });
+    }
+}
+
+void SshExecutor::handleCacheMarker(HostJob& job, ArtifactCache::Marker marker)
+{
+    job.cacheHit = marker == ArtifactCache::Marker::Hit;
+    if (job.relay) {
+        // Данные потомку отправляет родитель
+        return;
+    }
+
+    job.usedDelta = marker == ArtifactCache::Marker::Delta;
+    if (job.cacheHit) {
+        job.process->closeWriteChannel();
+        return;
+    }
+
+    QString path = job.step == CopyScript ? m_scriptPath : m_archivePath;
+    if (job.usedDelta) {
+        path = m_archiveDelta.patchPath;
+    }
+    job.source = new QFile(path);
+    job.bytesSent = 0;
+    if (!job.source->open(QIODevice::ReadOnly)) {
+        emit outputReceived(QString("❌ [%1] Не удалось открыть файл: %2").arg(job.host.endpoint(), path));
+        closeSource(job);
+        job.process->closeWriteChannel();
+        return;
+    }
+    feedSource(job);
+}
+
+void SshExecutor::feedSource(HostJob& job)
+{
+    while (job.source && job.process->bytesToWrite() < kStreamMaxBuffered) {
+        QByteArray chunk = job.source->read(kStreamChunkSize);
+        if (chunk.isEmpty()) {
+            closeSource(job);
+            job.process->closeWriteChannel();
+            break;
+        }
+        job.bytesSent += chunk.size();
+        job.process->write(chunk);
+    }
+}
+
+void SshExecutor::closeSource(HostJob& job)
+{
+    if (!job.source) return;
+
+    job.source->close();
+    delete job.source;
+    job.source = nullptr;
+}
+
+void SshExecutor::finishStep(HostJob& job, bool success)
+{
+    if (!success && job.relay && !job.timedOut && m_isRunning) {
+        // Ретрансляция не удалась - загружаем архив напрямую с управляющей машины
+        emit outputReceived(QString("⚠️ [%1] Ретрансляция от %2 не удалась, прямая загрузка")
+                            .arg(job.host.endpoint(), m_jobs[job.parent].host.endpoint()));
+        job.process->deleteLater();
+        job.process = nullptr;
+        --m_activeCount;
+        job.relay = false;
+        job.relayFailed = true;
+        job.cacheHit = false;
+        startStep(job);
+        return;
+    }
+
+    bool transferred = job.source == nullptr && job.bytesSent > 0;
+    closeSource(job);
+    if (job.process) {
+        job.process->deleteLater();
+        job.process = nullptr;
+        --m_activeCount;
+    }
+
+    if ((job.step == CopyScript || job.step == CopyArchive) && success) {
+        const ArtifactCache::Artifact& artifact = job.step == CopyScript ? m_scriptArtifact : m_archiveArtifact;
+        if (job.relay) {
+            emit outputReceived(QString("🌳 [%1] Архив получен от %2")
+                                .arg(job.host.endpoint(), m_jobs[job.parent].host.endpoint()));
+            emit artifactTransferred(job.host.endpoint(), 0, artifact.size);
+        } else if (job.cacheHit) {
+            emit artifactTransferred(job.host.endpoint(), 0, artifact.size);
+        } else if (transferred && job.usedDelta) {
+            emit outputReceived(QString("🧬 [%1] Архив собран из прошлой версии по патчу %2")
+                                .arg(job.host.endpoint(), ArtifactCache::formatBytes(job.bytesSent)));
+            emit artifactTransferred(job.host.endpoint(), job.bytesSent,
+                                     qMax<qint64>(0, artifact.size - job.bytesSent));
+        } else if (transferred) {
+            double seconds = qMax<qint64>(1, job.stepTimer.elapsed()) / 1000.0;
+            double megabytes = job.bytesSent / (1024.0 * 1024.0);
+            emit outputReceived(QString("📦 [%1] %2: %3 за %4 с (%5 МБ/с)")
+                                .arg(job.host.endpoint(), stepName(job.step),
+                                     ArtifactCache::formatBytes(job.bytesSent))
+                                .arg(seconds, 0, 'f', 1)
+                                .arg(megabytes / seconds, 0, 'f', 1));
+            emit artifactTransferred(job.host.endpoint(), job.bytesSent, 0);
+        }
+    }
+    if (job.step == CopyArchive && success) {
+        job.archiveReady = true;
+    }
+    job.bytesSent = 0;
+    job.cacheHit = false;
+    job.usedDelta = false;
+    job.relay = false;
+
+    ++m_completedSteps;
+    int total = m_jobs.size() * stepsPerHost();
+    emit hostStepFinished(job.host.endpoint(), stepName(job.step), success);
+
+    if (!success) {
+        job.failed = true;
+        emit outputReceived(QString("❌ [%1] Ошибка на шаге: %2").arg(job.host.endpoint(), stepName(job.step)));
+
+        // Оставшиеся шаги хоста засчитываем как пройденные, чтобы прогресс дошел до конца
+        for (Step s = nextStep(job.step); s != Done; s = nextStep(s)) {
+            ++m_completedSteps;
+        }
+        job.step = Done;
+    } else {
+        emit progressUpdated(m_completedSteps, total, stepName(job.step));
+        job.step = nextStep(job.step);
+    }
+
+    if (job.step == Done) {
+        job.finished = true;
+        emit hostFinished(job.host.endpoint(), !job.failed, job.unreachable);
+        emit progressUpdated(m_completedSteps, total,
+                             QString("Хост %1 обработан").arg(job.host.endpoint()));
+    }
+
+    if (!m_isRunning) return;
+
+    if (!job.finished && m_activeCount < m_maxParallel && !isWaitingForParent(job)) {
+        startStep(job);
+    }
+
+    scheduleJobs();
+    checkAllFinished();
+}
+
+SshExecutor::Step SshExecutor::nextStep(Step step) const
+{
+    switch (step) {
+        case CopyScript:
+            return m_archivePath.isEmpty() ? Execute : CopyArchive;
+        case CopyArchive:
+            return Execute;
+        default:
+            return Done;
+    }
+}
+
+QString SshExecutor::stepName(Step step) const
+{
+    switch (step) {
+        case CopyScript:
+            return "Копирование скрипта";
+        case CopyArchive:
+            return isStreaming() ? "Потоковая передача архива" : "Копирование архива";
+        case Execute:
+            return "Выполнение скрипта";
+        default:
+            return "Завершение";
+    }
+}
+
+QStringList SshExecutor::sshOptions(const HostConfig& host) const
+{
+    QStringList options;
+    options << "-p" << QString::number(host.sshPort);
+    options << "-o" << "StrictHostKeyChecking=no";
+    options << "-o" << "UserKnownHostsFile=/dev/null";
+    options << "-o" << "LogLevel=ERROR";
+    options << "-o" << "ConnectTimeout=10";
+    // Подключаемся через общий мастер, если он уже поднят пулом
+    options << SshConnectionPool::controlOptions();
+    if (!host.sshPass.isEmpty()) {
+        options << "-o" << "PubkeyAuthentication=no";
+        options << "-o" << "PasswordAuthentication=yes";
+    } else {
+        options << "-o" << "BatchMode=yes";
+    }
+    return options;
+}
+
+QStringList SshExecutor::buildStepArguments(const HostJob& job) const
+{
+    const HostConfig& host = job.relay ? m_jobs[job.parent].host : job.host;
+    QString target = host.sshUser + "@" + host.address;
+
+    QStringList args;
+    if (!host.sshPass.isEmpty()) {
+        args << "sshpass" << "-e";
+    }
+
+    if (job.relay) {
+        // Родитель пересылает blob из своего кэша; дельта при ретрансляции не используется
+        QString childCommand = isStreaming()
+            ? ArtifactCache::streamExtractCommand(m_archiveArtifact, QFileInfo(m_archivePath).fileName())
+            : ArtifactCache::fetchCommand(m_archiveArtifact, RemoteBundle::archiveDest, true);
+        // Агент пробрасывается на родителя: потомок принимает только ключ
+        args << "ssh" << sshOptions(host) << "-A";
+        args << target << FanoutTree::relayCommand(job.host, m_archiveArtifact.sha256, childCommand);
+        return args;
+    }
+
+    switch (job.step) {
+        case CopyScript:
+            args << "ssh" << sshOptions(host) << target
+                 << ArtifactCache::fetchCommand(m_scriptArtifact, RemoteBundle::scriptDest, false);
+            break;
+        case CopyArchive:
+            args << "ssh" << sshOptions(host) << target;
+            if (isStreaming()) {
+                args << ArtifactCache::streamExtractCommand(m_archiveArtifact,
+                                                            QFileInfo(m_archivePath).fileName(),
+                                                            m_archiveDelta);
+            } else {
+                args << ArtifactCache::fetchCommand(m_archiveArtifact, RemoteBundle::archiveDest, true,
+                                                    m_archiveDelta);
+            }
+            break;
+        default:
+            args << "ssh" << sshOptions(host) << target << "bash -s";
+            break;
+    }
+
+    return args;
+}
+
+QString SshExecutor::buildRemoteCommand(const HostConfig& host) const
+{
+    // Все шаги ansible.yml на хосте - одним сценарием bash
+    RemoteBundle bundle;
+    bundle.setArchiveName(m_archivePath.isEmpty() ? QString() : QFileInfo(m_archivePath).fileName());
+    bundle.setArchiveStreamed(isStreaming());
+    if (m_fusedMode) {
+        bundle.setScriptContent(m_scriptContent);
+    }
+    return QString("BUNDLE_HOST=%1\n").arg(shellQuote(host.address)) + bundle.build();
+}
+
+QString SshExecutor::shellQuote(const QString& value)
+{
+    QString quoted = value;
+    quoted.replace("'", "'\\''");
+    return "'" + quoted + "'";
+}
+
+SshExecutor::HostJob* SshExecutor::findJob(QProcess *process)
+{
+    for (HostJob& job : m_jobs) {
+        if (job.process == process) {
+            return &job;
+        }
+    }
+    return nullptr;
+}
+
+void SshExecutor::checkAllFinished()
+{
+    if (!m_isRunning) return;
+
+    bool allSuccess = true;
+    for (const HostJob& job : m_jobs) {
+        if (!job.finished) return;
+        if (job.failed) allSuccess = false;
+    }
+
+    m_isRunning = false;
+    m_watchdog->stop();
+    emit finished(allSuccess);
+}
+
+void SshExecutor::onHostProcessFinished(int exitCode, QProcess::ExitStatus status)
+{
+    QProcess *process = qobject_cast<QProcess*>(sender());
+    HostJob *job = findJob(process);
+    if (!job) return;
+
+    onHostProcessOutput();
+    job->output.flush([this, job](const QByteArray& line) {
+        handleOutputLine(*job, line);
+    });
+    ProcessTree::release(job->pidFile);
+    // 255 - код ошибки самого ssh (хост не ответил или не пустил), но только
+    // если удаленная команда так и не запустилась: скрипт тоже может выйти с 255
+    job->unreachable = status == QProcess::NormalExit && exitCode == 255 && !job->remoteStarted;
+    finishStep(*job, exitCode == 0 && status == QProcess::NormalExit);
+}
+
+void SshExecutor::onHostProcessErrorOccurred(QProcess::ProcessError error)
+{
+    // Остальные ошибки приходят вместе с finished()
+    if (error != QProcess::FailedToStart) return;
+
+    QProcess *process = qobject_cast<QProcess*>(sender());
+    HostJob *job = findJob(process);
+    if (!job) return;
+
+    emit outputReceived(QString("❌ [%1] Не удалось запустить ssh через WSL").arg(job->host.endpoint()));
+    finishStep(*job, false);
+}
+
+void SshExecutor::onHostProcessOutput()
+{
+    QProcess *process = qobject_cast<QProcess*>(sender());
+    HostJob *job = findJob(process);
+    if (!job) return;
+
+    // Каждая строка уходит в журнал сразу, пока скрипт на хосте еще работает
+    job->output.readFrom(process, [this, job](const QByteArray& line) {
+        handleOutputLine(*job, line);
+    });
+}
+
+void SshExecutor::handleOutputLine(HostJob& job, const QByteArray& line)
+{
+    QString trimmed = QString::fromUtf8(line).trimmed();
+
+    // Маркеры кэша печатает только команда копирования, и только первой строкой
+    // ответа; в выводе скрипта такие строки - обычный текст
+    if ((job.step == CopyScript || job.step == CopyArchive) && !job.markerSeen) {
+        ArtifactCache::Marker marker = ArtifactCache::parseMarker(trimmed);
+        if (marker != ArtifactCache::Marker::None) {
+            job.markerSeen = true;
+            job.remoteStarted = true;
+            handleCacheMarker(job, marker);
+            return;
+        }
+    }
+
+    RemoteBundle::StepStatus step;
+    if (job.step == Execute && RemoteBundle::parseStepLine(trimmed, step)) {
+        job.remoteStarted = true;
+        if (!step.finished) {
+            emit hostStepStarted(job.host.endpoint(), RemoteBundle::stepTitle(step.id));
+        }
+    }
+
+    if (!trimmed.isEmpty()) {
+        emit outputReceived(QString("[%1] %2").arg(job.host.endpoint(), trimmed));
+    }
+}
@@ -0,0 +1,159 @@
+#include "updatecoalescer.h"
+
+namespace {
+// Предел строк в одной пачке: дальше GUI все равно не успевает их показать
+const int kMaxPendingLines = 20000;
+}
+
+UpdateCoalescer::UpdateCoalescer(QObject *parent)
+    : QObject(parent)
+    , m_progressManager(nullptr)
+    , m_droppedSinceFlush(0)
+    , m_hasProgress(false)
+    , m_progress(0)
+    , m_hasStatus(false)
+    , m_hasEta(false)
+    , m_eta(0)
+{
+    // Таймер взводится первым обновлением, в простое он не работает
+    m_timer.setSingleShot(true);
+    m_timer.setInterval(16);
+    connect(&m_timer, &QTimer::timeout, this, &UpdateCoalescer::flush);
+}
+
+void UpdateCoalescer::setProgressManager(ProgressManager *manager)
+{
+    m_progressManager = manager;
+}
+
+void UpdateCoalescer::setInterval(int msec)
+{
+    m_timer.setInterval(qMax(1, msec));
+}
+
+void UpdateCoalescer::schedule()
+{
+    if (!m_timer.isActive()) {
+        m_timer.start();
+    }
+}
+
+void UpdateCoalescer::appendLine(const QString& text)
+{
+    if (m_lines.size() >= kMaxPendingLines) {
+        ++m_droppedSinceFlush;
+        ++m_stats.dropped;
+        return;
+    }
+    m_lines.append(text);
+    schedule();
+}
+
+void UpdateCoalescer::setProgress(int value)
+{
+    if (m_hasProgress) ++m_stats.merged;
+    m_hasProgress = true;
+    m_progress = value;
+    schedule();
+}
+
+void UpdateCoalescer::setStatusText(const QString& text)
+{
+    if (m_hasStatus) ++m_stats.merged;
+    m_hasStatus = true;
+    m_status = text;
+    schedule();
+}
+
+void UpdateCoalescer::setHostProgress(const QString& endpoint, int percent)
+{
+    if (m_hostProgress.contains(endpoint)) ++m_stats.merged;
+    m_hostProgress.insert(endpoint, percent);
+    schedule();
+}
+
+void UpdateCoalescer::setHostEta(const QString& endpoint, qint64 remainingMs, bool slow)
+{
+    if (m_hostEta.contains(endpoint)) ++m_stats.merged;
+    m_hostEta.insert(endpoint, qMakePair(remainingMs, slow));
+    schedule();
+}
+
+void UpdateCoalescer::setEta(qint64 remainingMs)
+{
+    if (m_hasEta) ++m_stats.merged;
+    m_hasEta = true;
+    m_eta = remainingMs;
+    schedule();
+}
+
+void UpdateCoalescer::startProgress()
+{
+    // Значения прошлого запуска не должны попасть в новый
+    m_hasProgress = false;
+    m_hasStatus = false;
+    m_hostProgress.clear();
+    m_hostEta.clear();
+    m_hasEta = false;
+    flush();
+    if (m_progressManager) m_progressManager->startProgress(100);
+}
+
+void UpdateCoalescer::stopProgress(bool success)
+{
+    flush();
+    if (m_progressManager) m_progressManager->stopProgress(success);
+}
+
+void UpdateCoalescer::flush()
+{
+    m_timer.stop();
+    if (m_lines.isEmpty() && m_droppedSinceFlush == 0 && !m_hasProgress
+            && !m_hasStatus && m_hostProgress.isEmpty() && m_hostEta.isEmpty() && !m_hasEta) {
+        return;
+    }
+
+    ++m_stats.flushes;
+
+    if (m_droppedSinceFlush > 0) {
+        m_lines.append(QString("⏭ Пропущено строк вывода: %1").arg(m_droppedSinceFlush));
+        m_droppedSinceFlush = 0;
+    }
+    if (!m_lines.isEmpty()) {
+        m_stats.lines += m_lines.size();
+        QStringList lines;
+        lines.swap(m_lines);
+        emit linesReady(lines);
+    }
+
+    if (m_progressManager) {
+        if (m_hasProgress) m_progressManager->updateProgress(m_progress);
+        if (m_hasStatus) m_progressManager->setStatusText(m_status);
+        for (auto it = m_hostProgress.constBegin(); it != m_hostProgress.constEnd(); ++it) {
+            m_progressManager->updateHostProgress(it.key(), it.value());
+        }
+        for (auto it = m_hostEta.constBegin(); it != m_hostEta.constEnd(); ++it) {
+            m_progressManager->updateHostEta(it.key(), it.value().first, it.value().second);
+        }
+        if (m_hasEta) m_progressManager->setEta(m_eta);
+    }
+    m_hasProgress = false;
+    m_hasStatus = false;
+    m_hostProgress.clear();
+    m_hostEta.clear();
+    m_hasEta = false;
+}
+
+void UpdateCoalescer::resetStats()
+{
+    m_stats = Stats();
+}
+
+QString UpdateCoalescer::summary() const
+{
+    return QString("🖥 Обновления интерфейса: %1 кадров, %2 строк, объединено %3, отброшено %4")
+        .arg(m_stats.flushes)
+        .arg(m_stats.lines)
+        .arg(m_stats.merged)
+        .arg(m_stats.dropped);
+}
@@ -1,4 +1,5 @@
 #include "windowgraphics.h"
+#include <QSignalBlocker>
 #include <QDragEnterEvent>
 #include <QMimeData>
 
@@ -83,6 +84,59 @@ void WindowGraphics::setupUI()
     progressLayout->addWidget(progressBar);
     mainLayout->addWidget(progressGroup);
 
+    // ----- СЕКЦИЯ ВЫБОРА ДВИЖКА -----
+    QHBoxLayout *engineLayout = new QHBoxLayout();
+    engineComboBox = new QComboBox();
+    engineComboBox->addItem("Ansible playbook");
+    engineComboBox->addItem("Прямой SSH (параллельно)");
+    engineLayout->addWidget(new QLabel("Способ выполнения:"));
+    engineLayout->addWidget(engineComboBox, 1);
+
+    batchSizeSpinBox = new QSpinBox();
+    batchSizeSpinBox->setRange(0, 10000);
+    batchSizeSpinBox->setSpecialValueText("все");
+    batchSizeSpinBox->setToolTip("Сколько хостов обрабатывать за одну партию");
+    engineLayout->addWidget(new QLabel("Партия:"));
+    engineLayout->addWidget(batchSizeSpinBox);
+
+    concurrencySpinBox = new QSpinBox();
+    concurrencySpinBox->setRange(0, 500);
+    concurrencySpinBox->setSpecialValueText("авто");
+    concurrencySpinBox->setToolTip("Число одновременно обрабатываемых хостов (forks)");
+    engineLayout->addWidget(new QLabel("Параллельно:"));
+    engineLayout->addWidget(concurrencySpinBox);
+
+    fusedCheckBox = new QCheckBox("Слитный режим");
+    fusedCheckBox->setToolTip("Все шаги на хосте выполняются одним сценарием за одно подключение");
+    engineLayout->addWidget(fusedCheckBox);
+
+    streamArchiveCheckBox = new QCheckBox("Потоковая передача архива");
+    streamArchiveCheckBox->setToolTip("Архив (tar, tar.gz) передается потоком и распаковывается на хосте без промежуточной копии");
+    engineLayout->addWidget(streamArchiveCheckBox);
+
+    liveOutputCheckBox = new QCheckBox("Вывод в реальном времени");
+    liveOutputCheckBox->setToolTip("Строки вывода скрипта появляются в журнале по мере выполнения, а не после его завершения");
+    engineLayout->addWidget(liveOutputCheckBox);
+
+    fanoutSpinBox = new QSpinBox();
+    fanoutSpinBox->setRange(0, 64);
+    fanoutSpinBox->setSpecialValueText("выкл");
+    fanoutSpinBox->setToolTip("Архив загружается на указанное число хостов, остальные получают его друг от друга по дереву");
+    engineLayout->addWidget(new QLabel("Раздача деревом:"));
+    engineLayout->addWidget(fanoutSpinBox);
+
+    preflightSpinBox = new QSpinBox();
+    preflightSpinBox->setRange(0, 10000);
+    preflightSpinBox->setSingleStep(250);
+    preflightSpinBox->setValue(1500);
+    preflightSpinBox->setSpecialValueText("выкл");
+    preflightSpinBox->setSuffix(" мс");
+    preflightSpinBox->setToolTip("Перед запуском SSH-порты всех хостов проверяются параллельно с этим сроком; "
+                                 "не ответившие хосты откладываются и не задерживают запуск");
+    engineLayout->addWidget(new QLabel("Проверка доступности:"));
+    engineLayout->addWidget(preflightSpinBox);
+    mainLayout->addLayout(engineLayout);
+
     // ----- СЕКЦИЯ КНОПКИ ЗАПУСКА -----
     playButton = new QPushButton("Play");
     playButton->setStyleSheet(
@@ -103,16 +157,107 @@ void WindowGraphics::setupUI()
     );
     mainLayout->addWidget(playButton);
 
+    // ----- СЕКЦИЯ ОЧЕРЕДИ ЗАПУСКОВ -----
+    QGroupBox *queueGroup = new QGroupBox("Очередь запусков");
+    QVBoxLayout *queueLayout = new QVBoxLayout(queueGroup);
+    QHBoxLayout *queueControlLayout = new QHBoxLayout();
+    maxRunsSpinBox = new QSpinBox();
+    maxRunsSpinBox->setRange(1, 8);
+    maxRunsSpinBox->setToolTip("Сколько запусков выполняется одновременно; запуски с общими хостами идут по очереди");
+    cancelRunButton = new QPushButton("Отменить");
+    cancelRunButton->setToolTip("Снять выбранный запуск с очереди или остановить его");
+    queueControlLayout->addWidget(new QLabel("Одновременно запусков:"));
+    retriesSpinBox = new QSpinBox();
+    retriesSpinBox->setRange(0, 5);
+    retriesSpinBox->setSpecialValueText("нет");
+    retriesSpinBox->setToolTip("Сколько раз автоматически повторять хосты с ошибкой или недоступные (пауза растет вдвое)");
+    retryFailedButton = new QPushButton("Повторить сбойные");
+    retryFailedButton->setToolTip("Перезапустить выбранный запуск только на хостах с ошибкой, недоступных, превысивших время и не запускавшихся");
+    queueControlLayout->addWidget(maxRunsSpinBox);
+    queueControlLayout->addWidget(new QLabel("Повторы при сбое:"));
+    queueControlLayout->addWidget(retriesSpinBox);
+    queueControlLayout->addStretch(1);
+    queueControlLayout->addWidget(retryFailedButton);
+    queueControlLayout->addWidget(cancelRunButton);
+    QHBoxLayout *rolloutLayout = new QHBoxLayout();
+    canarySpinBox = new QSpinBox();
+    canarySpinBox->setRange(0, 1000);
+    canarySpinBox->setSpecialValueText("нет");
+    canarySpinBox->setToolTip("Сначала скрипт выполняется на указанном числе хостов; остальные - только если ошибок не больше порога");
+    maxFailSpinBox = new QSpinBox();
+    maxFailSpinBox->setRange(0, 100);
+    maxFailSpinBox->setValue(100);
+    maxFailSpinBox->setSuffix("%");
+    maxFailSpinBox->setToolTip("Если доля хостов с ошибкой выше порога, оставшиеся партии не запускаются; 100% - не прерывать "
+                               "(при канареечном запуске 100% заменяется на 0%)");
+    rolloutLayout->addWidget(new QLabel("Канареечные хосты:"));
+    rolloutLayout->addWidget(canarySpinBox);
+    rolloutLayout->addWidget(new QLabel("Порог ошибок:"));
+    rolloutLayout->addWidget(maxFailSpinBox);
+    taskTimeoutSpinBox = new QSpinBox();
+    taskTimeoutSpinBox->setRange(0, 86400);
+    taskTimeoutSpinBox->setSpecialValueText("нет");
+    taskTimeoutSpinBox->setSuffix(" с");
+    taskTimeoutSpinBox->setToolTip("Предел времени одной задачи (шага) на хосте; зависший хост останавливается, остальные продолжают");
+    hostTimeoutSpinBox = new QSpinBox();
+    hostTimeoutSpinBox->setRange(0, 86400);
+    hostTimeoutSpinBox->setSpecialValueText("нет");
+    hostTimeoutSpinBox->setSuffix(" с");
+    hostTimeoutSpinBox->setToolTip("Предел времени всего хоста; хост, не уложившийся в него, помечается как превысивший время");
+    rolloutLayout->addWidget(new QLabel("Предел задачи:"));
+    rolloutLayout->addWidget(taskTimeoutSpinBox);
+    rolloutLayout->addWidget(new QLabel("хоста:"));
+    rolloutLayout->addWidget(hostTimeoutSpinBox);
+    rolloutLayout->addStretch(1);
+    runQueueListWidget = new QListWidget();
+    runQueueListWidget->setMaximumHeight(90);
+    queueLayout->addLayout(queueControlLayout);
+    queueLayout->addLayout(rolloutLayout);
+    queueLayout->addWidget(runQueueListWidget);
+    mainLayout->addWidget(queueGroup);
+
     // ----- СЕКЦИЯ ВЫВОДА ANSIBLE -----
     QGroupBox *outputGroup = new QGroupBox("Вывод Ansible");
     QVBoxLayout *outputLayout = new QVBoxLayout(outputGroup);
 
-    outputTextEdit = new QTextEdit();
-    outputTextEdit->setReadOnly(true);
-    outputTextEdit->setMinimumHeight(200);
-    outputTextEdit->setFontFamily("Courier New");
+    outputView = new LogView();
+    outputView->setMinimumHeight(200);
+
+    // Журнал отдельного хоста и переход к задаче в нем
+    QHBoxLayout *logFilterLayout = new QHBoxLayout();
+    hostLogComboBox = new QComboBox();
+    hostLogComboBox->addItem("Все хосты", QString());
+    taskLogComboBox = new QComboBox();
+    taskLogComboBox->setEnabled(false);
+    logFilterLayout->addWidget(new QLabel("Журнал:"));
+    logFilterLayout->addWidget(hostLogComboBox, 1);
+    logFilterLayout->addWidget(new QLabel("Задача:"));
+    logFilterLayout->addWidget(taskLogComboBox, 2);
+
+    connect(outputView, &LogView::hostAdded, this, [this](const QString& host) {
+        hostLogComboBox->addItem(host, host);
+    });
+    connect(outputView, &LogView::taskAdded, this, [this](const QString& host, const QString& task) {
+        if (host == outputView->currentHost()) {
+            taskLogComboBox->addItem(task);
+        }
+    });
+    connect(hostLogComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [this](int index) {
+        QString host = hostLogComboBox->itemData(index).toString();
+        outputView->setCurrentHost(host);
 
-    outputLayout->addWidget(outputTextEdit);
+        QSignalBlocker blocker(taskLogComboBox);
+        taskLogComboBox->clear();
+        const QVector<LogView::TaskMark> tasks = outputView->tasks(host);
+        for (const LogView::TaskMark& mark : tasks) {
+            taskLogComboBox->addItem(mark.task);
+        }
+        taskLogComboBox->setEnabled(!host.isEmpty());
+    });
+    connect(taskLogComboBox, QOverload<int>::of(&QComboBox::activated), outputView, &LogView::scrollToTask);
+
+    outputLayout->addLayout(logFilterLayout);
+    outputLayout->addWidget(outputView);
     mainLayout->addWidget(outputGroup);
     mainLayout->addWidget(statusBar);
 }
@@ -128,7 +273,12 @@ void WindowGraphics::updateFilePathLabel(const QString& text, bool success)
 
 void WindowGraphics::appendOutput(const QString& text)
 {
-    outputTextEdit->append(text);
+    outputView->appendLine(text);
+}
+
+void WindowGraphics::appendOutputLines(const QStringList& lines)
+{
+    outputView->appendLines(lines);
 }
 
 void WindowGraphics::appendStatusBar(const QString& text)
@@ -136,9 +286,19 @@ void WindowGraphics::appendStatusBar(const QString& text)
     statusBar->showMessage(text);
 }
 
+void WindowGraphics::appendHostOutput(const QString& host, const QString& task, const QString& text)
+{
+    outputView->appendHostLine(host, task, text);
+}
+
 void WindowGraphics::clearOutput()
 {
-    outputTextEdit->clear();
+    outputView->clear();
+    hostLogComboBox->setCurrentIndex(0);
+    while (hostLogComboBox->count() > 1) {
+        hostLogComboBox->removeItem(1);
+    }
+    taskLogComboBox->clear();
 }
 
 void WindowGraphics::addHostToList(const QString& hostInfo)
@@ -151,6 +311,43 @@ void WindowGraphics::removeHostFromList(int row)
     delete hostsListWidget->takeItem(row);
 }
 
+void WindowGraphics::setHostStatus(int row, const QString& status)
+{
+    QListWidgetItem *item = hostsListWidget->item(row);
+    if (!item) return;
+
+    // Исходный текст храним в UserRole, статус дописываем справа
+    if (!item->data(Qt::UserRole).isValid()) {
+        item->setData(Qt::UserRole, item->text());
+    }
+    QString baseText = item->data(Qt::UserRole).toString();
+    item->setText(status.isEmpty() ? baseText : baseText + "   " + status);
+}
+
+void WindowGraphics::setRunQueueItem(int jobId, const QString& text)
+{
+    for (int i = 0; i < runQueueListWidget->count(); ++i) {
+        QListWidgetItem *item = runQueueListWidget->item(i);
+        if (item->data(Qt::UserRole).toInt() == jobId) {
+            item->setText(text);
+            return;
+        }
+    }
+    QListWidgetItem *item = new QListWidgetItem(text);
+    item->setData(Qt::UserRole, jobId);
+    runQueueListWidget->addItem(item);
+}
+
+void WindowGraphics::removeRunQueueItem(int jobId)
+{
+    for (int i = 0; i < runQueueListWidget->count(); ++i) {
+        if (runQueueListWidget->item(i)->data(Qt::UserRole).toInt() == jobId) {
+            delete runQueueListWidget->takeItem(i);
+            return;
+        }
+    }
+}
+
 // void WindowGraphics::dragEnterEvent(QDragEnterEvent *event)
 // {
 //     if (event->mimeData()->hasUrls()) {